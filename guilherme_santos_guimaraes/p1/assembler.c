@@ -3,171 +3,138 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include <ctype.h>
 
-#define MEM_SIZE 512
-#define HEADER_SIZE 4
-#define VAR_START 0x100
-#define MAX_TAGS 256
-#define MAX_LINE 256
-
-// OpCodes
-#define OP_NOP  0x00
-#define OP_STA  0x10
-#define OP_LDA  0x20
-#define OP_ADD  0x30
-#define OP_SUB  0x31
-#define OP_OR   0x40
-#define OP_AND  0x50
-#define OP_NOT  0x60
-#define OP_JMP  0x80
-#define OP_JMN  0x90
-#define OP_JMZ  0xA0
-#define OP_HLT  0xF0
-
-typedef struct {
-    char name[32];
-    int address;
-    bool defined;
-} Symbol;
-
-Symbol symbol_table[MAX_TAGS];
-int symbol_count = 0;
-uint8_t memory[MEM_SIZE] = {0};
-int pc = HEADER_SIZE;
-int var_ptr = VAR_START;
-
-void add_symbol(const char* name, int address, bool defined) {
-    for (int i = 0; i < symbol_count; i++) {
-        if (strcmp(symbol_table[i].name, name) == 0)
-            return; // Já existe
+#include "neander.h"
+
+// Identifica a versão nas chaves do cache; o Makefile passa um checksum das fontes
+#ifndef NEANDER_BUILD_ID
+#define NEANDER_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+/*
+ * Assembler de texto: lê o .asm inteiro e o monta com neander_assemble,
+ * a mesma montagem que o compilador usa com --emit=bin. Com --cache o
+ * binário é guardado no cache endereçado pelo conteúdo (neander_cache.c).
+ */
+
+// Lê o arquivo inteiro; o texto não precisa terminar em NUL
+static char* read_file(FILE* in, size_t* len) {
+    size_t capacity = 4096;
+    char* text = malloc(capacity);
+    *len = 0;
+    for (size_t got; text && (got = fread(text + *len, 1, capacity - *len, in)) > 0; ) {
+        *len += got;
+        if (*len == capacity) {
+            capacity *= 2;
+            char* bigger = realloc(text, capacity);
+            if (!bigger) free(text);
+            text = bigger;
+        }
     }
-    strncpy(symbol_table[symbol_count].name, name, sizeof(symbol_table[symbol_count].name));
-    symbol_table[symbol_count].address = address;
-    symbol_table[symbol_count].defined = defined;
-    symbol_count++;
+    return text;
 }
 
-int get_symbol_address(const char* name) {
-    for (int i = 0; i < symbol_count; i++) {
-        if (strcmp(symbol_table[i].name, name) == 0)
-            return symbol_table[i].address;
+int main(int argc, char* argv[]) {
+    bool legacy = false;
+    const char* files[2];
+    int nfiles = 0;
+    bool use_cache = getenv("NEANDER_CACHE_DIR") != NULL;
+    const char* cache_dir = NULL;
+    bool show_stats = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format=v1") == 0) legacy = true;
+        else if (strcmp(argv[i], "--format=v2") == 0) legacy = false;
+        else if (strcmp(argv[i], "--cache") == 0) use_cache = true;
+        else if (strncmp(argv[i], "--cache=", 8) == 0) { use_cache = true; cache_dir = argv[i] + 8; }
+        else if (strcmp(argv[i], "--no-cache") == 0) use_cache = false;
+        else if (strcmp(argv[i], "--cache-stats") == 0) show_stats = true;
+        else if (nfiles < 2) files[nfiles++] = argv[i];
     }
 
-    // Se não existe, cria nova entrada
-    if (var_ptr % 2 != 0) var_ptr++;  // alinhamento
-    int addr = var_ptr;
-    add_symbol(name, addr, false);
-    var_ptr += 2;
-    return addr;
-}
-
-uint8_t get_opcode(const char* mnemonic) {
-    if (strcasecmp(mnemonic, "NOP") == 0) return OP_NOP;
-    if (strcasecmp(mnemonic, "STA") == 0) return OP_STA;
-    if (strcasecmp(mnemonic, "LDA") == 0) return OP_LDA;
-    if (strcasecmp(mnemonic, "ADD") == 0) return OP_ADD;
-    if (strcasecmp(mnemonic, "SUB") == 0) return OP_SUB;
-    if (strcasecmp(mnemonic, "OR")  == 0) return OP_OR;
-    if (strcasecmp(mnemonic, "AND") == 0) return OP_AND;
-    if (strcasecmp(mnemonic, "NOT") == 0) return OP_NOT;
-    if (strcasecmp(mnemonic, "JMP") == 0) return OP_JMP;
-    if (strcasecmp(mnemonic, "JMN") == 0) return OP_JMN;
-    if (strcasecmp(mnemonic, "JMZ") == 0) return OP_JMZ;
-    if (strcasecmp(mnemonic, "HLT") == 0) return OP_HLT;
-    return 0xFF;
-}
-
-int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        fprintf(stderr, "Uso: %s programa.asm programa.bin\n", argv[0]);
+    if (nfiles == 0 && show_stats) {
+        neander_cache_print_stats(cache_dir, stdout);
+        return 0;
+    }
+    if (nfiles < 2) {
+        fprintf(stderr, "Uso: %s [--format=v1|v2] [--cache[=dir]] [--no-cache] [--cache-stats] programa.asm programa.bin\n", argv[0]);
         return 1;
     }
 
-    FILE* src = fopen(argv[1], "r");
+    FILE* src = fopen(files[0], "r");
     if (!src) {
         perror("Erro ao abrir arquivo ASM");
         return 1;
     }
 
-    FILE* out = fopen(argv[2], "wb");
+    FILE* out = fopen(files[1], "wb");
     if (!out) {
         perror("Erro ao criar arquivo BIN");
         fclose(src);
         return 1;
     }
 
-    // Cabeçalho NDR
-    memory[0] = 0x03;
-    memory[1] = 'N';
-    memory[2] = 'D';
-    memory[3] = 'R';
+    size_t len;
+    char* text = read_file(src, &len);
+    fclose(src);
+    if (!text) {
+        perror("Erro ao ler arquivo ASM");
+        fclose(out);
+        return 1;
+    }
 
-    char line[MAX_LINE];
-    bool in_data = false, in_code = false;
+    NeanderCache cache;
+    if (use_cache && !neander_cache_open(&cache, cache_dir)) {
+        fprintf(stderr, "Aviso: cache indisponível em %s; montando sem cache\n", cache_dir ? cache_dir : neander_cache_dir());
+        use_cache = false;
+    }
 
-    while (fgets(line, sizeof(line), src)) {
-        char* token = strtok(line, " \t\r\n");
-        if (!token || token[0] == ';') continue;
+    // Acerto: o binário sai do cache sem montar
+    uint8_t* binary = NULL;
+    size_t binary_len = 0;
+    bool cached = false;
+    if (use_cache) {
+        neander_cache_key(&cache, "assembler " NEANDER_BUILD_ID, legacy ? "format=v1" : "format=v2", text, len);
+        cached = neander_cache_lookup(&cache) && (binary = neander_cache_load(&cache, "bin", &binary_len)) != NULL;
+    }
 
-        if (strcasecmp(token, ".DATA") == 0) {
-            in_data = true;
-            in_code = false;
-            continue;
-        } else if (strcasecmp(token, ".CODE") == 0) {
-            in_code = true;
-            in_data = false;
-            continue;
-        } else if (strcasecmp(token, ".ORG") == 0) {
-            strtok(NULL, " \t\r\n"); // Ignora valor
-            continue;
+    bool ok = true;
+    if (!cached) {
+        NeanderAssembler image;
+        ok = neander_assemble(&image, text, len);
+        if (ok && legacy) {
+            binary_len = MEM_SIZE;
+            binary = malloc(binary_len);
+            if (binary)
+                memcpy(binary, image.memory, binary_len);
+        } else if (ok) {
+            binary = neander_image_v2(&image, &binary_len);
+        } else {
+            fprintf(stderr, "%s\n", image.error);
         }
-
-        if (in_data) {
-            char* name = token;
-            strtok(NULL, " \t\r\n"); // DB
-            char* val = strtok(NULL, " \t\r\n");
-            int value = (val && strcmp(val, "?") != 0) ? atoi(val) : 0;
-            if (var_ptr % 2 != 0) var_ptr++; // alinhamento
-            add_symbol(name, var_ptr, true);
-            memory[var_ptr++] = value;
-            memory[var_ptr++] = 0x00;
-        } else if (in_code) {
-            if (strchr(token, ':')) continue; // Ignora labels
-
-            uint8_t opcode = get_opcode(token);
-            if (opcode == 0xFF) continue;
-
-            if (opcode == OP_HLT || opcode == OP_NOP || opcode == OP_NOT) {
-                memory[pc++] = opcode;
-                memory[pc++] = 0x00;
-                memory[pc++] = 0x00;
-                memory[pc++] = 0x00;
-            } else {
-                char* arg = strtok(NULL, " \t\r\n");
-                int addr = get_symbol_address(arg);
-                uint8_t addr_word = (addr - HEADER_SIZE) / 2;
-
-                memory[pc++] = opcode;
-                memory[pc++] = 0x00;
-                memory[pc++] = addr_word;
-                memory[pc++] = 0x00;
-            }
+        neander_free(&image);
+        if (ok && !binary) {
+            perror("Erro na alocação de memória");
+            ok = false;
+        }
+        if (ok && use_cache) {
+            neander_cache_begin(&cache);
+            neander_cache_put(&cache, "bin", binary, binary_len);
+            neander_cache_commit(&cache);
         }
     }
 
-    // Garante que termina com HLT
-    if (memory[pc - 4] != OP_HLT) {
-        memory[pc++] = OP_HLT;
-        memory[pc++] = 0x00;
-        memory[pc++] = 0x00;
-        memory[pc++] = 0x00;
+    if (ok && fwrite(binary, 1, binary_len, out) != binary_len) {
+        perror("Erro ao gravar arquivo BIN");
+        ok = false;
     }
-
-    fwrite(memory, 1, MEM_SIZE, out);
-    fclose(src);
+    free(text);
+    free(binary);
     fclose(out);
+    if (!ok)
+        return 1;
     printf("(successful) Binário gerado com sucesso!\n");
+    if (show_stats)
+        neander_cache_print_stats(use_cache ? cache.dir : cache_dir, stdout);
     return 0;
 }
-
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "neander.h"
+
+/*
+ * Micro-benchmark da análise léxica do compilador. Gera em memória um
+ * fonte LPN de vários megabytes (nomes de tamanhos variados, inclusive
+ * parecidos com palavras-chave, números, operadores e espaços, tabs e
+ * quebras de linha em sequência) e mede só neander_compiler_scan,
+ * repetindo e ficando com o melhor tempo.
+ */
+
+static uint64_t next_random(uint64_t *rng) {
+    // xorshift64*
+    *rng ^= *rng >> 12;
+    *rng ^= *rng << 25;
+    *rng ^= *rng >> 27;
+    return *rng * 2685821657736338717ULL;
+}
+
+static void append(char **buf, size_t *len, size_t *cap, const char *text, size_t n) {
+    if (*len + n > *cap) {
+        *cap = (*len + n) * 2;
+        *buf = realloc(*buf, *cap);
+        if (!*buf) {
+            perror("Erro na alocação de memória");
+            exit(1);
+        }
+    }
+    memcpy(*buf + *len, text, n);
+    *len += n;
+}
+
+static char *generate_source(size_t target, uint64_t seed, size_t *len) {
+    static const char *const names[] = {
+        "a", "b", "x1", "total", "RESULTADO", "FIMx", "INICIOS", "valor_parcial", "contador_de_voltas_2"
+    };
+    static const char *const blanks[] = { " ", " ", "  ", "\t", "    ", "\n", "\r\n", "\n\n\t" };
+    static const char ops[] = "+-*/%";
+    uint64_t rng = seed;
+    size_t cap = 0;
+    char *buf = NULL;
+    char tmp[32];
+
+    *len = 0;
+    const char *header = "PROGRAMA \"bench\":\nINICIO\n";
+    append(&buf, len, &cap, header, strlen(header));
+
+    while (*len < target) {
+        const char *name = names[next_random(&rng) % 9];
+        append(&buf, len, &cap, name, strlen(name));
+        append(&buf, len, &cap, " = ", 3);
+        int terms = 1 + next_random(&rng) % 6;
+        for (int t = 0; t < terms; t++) {
+            if (t > 0) {
+                const char *blank = blanks[next_random(&rng) % 8];
+                append(&buf, len, &cap, blank, strlen(blank));
+                append(&buf, len, &cap, &ops[next_random(&rng) % 5], 1);
+                append(&buf, len, &cap, " ", 1);
+            }
+            if (next_random(&rng) % 2) {
+                int n = snprintf(tmp, sizeof(tmp), "%u", (unsigned)(next_random(&rng) % 256));
+                append(&buf, len, &cap, tmp, n);
+            } else {
+                const char *operand = names[next_random(&rng) % 9];
+                append(&buf, len, &cap, "(", 1);
+                append(&buf, len, &cap, operand, strlen(operand));
+                append(&buf, len, &cap, ")", 1);
+            }
+        }
+        append(&buf, len, &cap, "\n", 1);
+    }
+
+    const char *footer = "RES = a\nFIM\n";
+    append(&buf, len, &cap, footer, strlen(footer));
+    return buf;
+}
+
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    long megabytes = 8, repeat = 5;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--size=", 7) == 0) {
+            megabytes = atol(argv[i] + 7);
+        } else if (strncmp(argv[i], "--repeat=", 9) == 0) {
+            repeat = atol(argv[i] + 9);
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            seed = strtoull(argv[i] + 7, NULL, 10);
+        } else {
+            fprintf(stderr, "Uso: %s [--size=MB] [--repeat=N] [--seed=N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (megabytes < 1) megabytes = 1;
+    if (repeat < 1) repeat = 1;
+    if (seed == 0) seed = 1;
+
+    size_t len;
+    char *source = generate_source((size_t)megabytes << 20, seed, &len);
+    NeanderCompiler *compiler = neander_compiler_new(NULL);
+
+    double best = 0;
+    int tokens = 0;
+    for (long r = 0; r < repeat; r++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        tokens = neander_compiler_scan(compiler, source, len);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double ms = elapsed_ms(&start, &end);
+        if (r == 0 || ms < best) best = ms;
+    }
+
+    printf("Fonte: %.1f MB, %d tokens\n", len / 1048576.0, tokens);
+    printf("Análise léxica: %.2f ms (melhor de %ld), %.1f MB/s, %.2f ns por token\n",
+           best, repeat, len / 1048576.0 / (best / 1e3), best * 1e6 / tokens);
+
+    neander_compiler_free(compiler);
+    free(source);
+    return 0;
+}
@@ -1,967 +1,519 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
-#include <stdbool.h>  // For boolean support
-
-/*========================================================================
-  Lexical Section - Token Processing
-========================================================================*/
-typedef enum {
-    TK_START,
-    TK_BEGIN,
-    TK_FINISH,
-    TK_RESULT,
-    TK_NAME,
-    TK_NUMBER,
-    TK_ASSIGN,
-    TK_ADD,
-    TK_SUBTRACT,
-    TK_MULTIPLY,
-    TK_DIVIDE,
-    TK_OPEN_BRACKET,
-    TK_CLOSE_BRACKET,
-    TK_DELIMITER,
-    TK_END_OF_FILE,
-    TK_INVALID
-} LexicalType;
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "neander.h"
+
+// Identifies the compiler build in cache keys; the Makefile passes a
+// checksum of the library and tool sources
+#ifndef NEANDER_BUILD_ID
+#define NEANDER_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+/*
+ * Command-line front end for the LPN compiler in neander_compiler.c:
+ * reads the source, compiles it with progress on stdout and writes the
+ * .asm listing and/or the .bin image next to it. With --cache the outputs
+ * and the progress log are kept in a content-addressed cache
+ * (neander_cache.c), so an unchanged source becomes a lookup and a copy.
+ *
+ * Given several sources or a directory, it becomes a build driver: the
+ * files are compiled and assembled on a pool of threads, each with its
+ * own NeanderCompiler, and one line per file reports the outcome.
+ */
+
+typedef enum { STATS_NONE, STATS_TEXT, STATS_JSON } StatsFormat;
 
 typedef struct {
-    LexicalType category;
-    char text[64];
-} LexicalToken;
+    NeanderCompileOptions options;
+    bool emitListing;
+    bool emitBinary;
+    bool useCache;
+    const char* cacheDir;
+    StatsFormat stats;
+} BuildSettings;
 
-#define TOKEN_CAPACITY 1024
-LexicalToken tokenArray[TOKEN_CAPACITY];
-int tokenTotal = 0;
-int currentIndex = 0;
-
-char* inputCode;
-int inputPosition = 0;
-
-void ignoreSpaces() {
-    while (inputCode[inputPosition] == ' ' || inputCode[inputPosition] == '\t')
-        inputPosition++;
-}
-
-int isAlpha(char c) {
-    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+typedef struct {
+    const char* sourcePath;
+    char listingFilename[PATH_MAX];
+    char binaryFilename[PATH_MAX];
+    bool compileFailed;     // message is a syntax error (stdout) rather than an I/O or assembly error
+    bool cacheHit;
+    double milliseconds;
+    char message[512];
+    bool hasStats;
+    NeanderCompileStats stats;
+} BuildJob;
+
+static double elapsedMilliseconds(const struct timespec* start, const struct timespec* end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
 }
 
-int isNumeric(char c) {
-    return (c >= '0' && c <= '9');
-}
+/*
+ * --stats: per-phase time and allocations plus the sizes that decide
+ * whether a program fits the machine, as text or as one JSON object per
+ * file (on stderr, so the progress log on stdout is unchanged).
+ */
+static const char* const phaseNames[NEANDER_PHASE_COUNT] = { "léxica", "sintática", "geração", "otimização" };
+static const char* const phaseKeys[NEANDER_PHASE_COUNT] = { "scan", "parse", "codegen", "optimize" };
 
-void insertToken(LexicalType category, const char *text) {
-    if (tokenTotal < TOKEN_CAPACITY) {
-        tokenArray[tokenTotal].category = category;
-        strncpy(tokenArray[tokenTotal].text, text, sizeof(tokenArray[tokenTotal].text)-1);
-        tokenArray[tokenTotal].text[sizeof(tokenArray[tokenTotal].text)-1] = '\0';
-        tokenTotal++;
-    }
+static void printSymbolCount(FILE* out, const char* key, const NeanderSymbolCount* count, bool last) {
+    fprintf(out, "\"%s\": {\"total\": %d, \"data\": %d}%s", key, count->total, count->data, last ? "" : ", ");
 }
 
-void scanTokens() {
-    tokenTotal = 0;
-    currentIndex = 0;  // Reset parsing index
-    inputPosition = 0;
-    
-    while (inputCode[inputPosition] != '\0') {
-        if (inputCode[inputPosition] == ' ' || inputCode[inputPosition] == '\t') {
-            ignoreSpaces();
-            continue;
-        }
-        
-        if (inputCode[inputPosition] == '\n' || inputCode[inputPosition] == '\r') {
-            // Skip line breaks
-            inputPosition++;
-            continue;
-        }
-        
-        // Check keywords
-        if (strncmp(&inputCode[inputPosition], "PROGRAMA", 8) == 0 && !isAlpha(inputCode[inputPosition+8])) {
-            insertToken(TK_START, "PROGRAMA");
-            inputPosition += 8;
-            continue;
-        }
-        
-        if (strncmp(&inputCode[inputPosition], "INICIO", 6) == 0 && !isAlpha(inputCode[inputPosition+6])) {
-            insertToken(TK_BEGIN, "INICIO");
-            inputPosition += 6;
-            continue;
-        }
-        
-        if (strncmp(&inputCode[inputPosition], "FIM", 3) == 0 && !isAlpha(inputCode[inputPosition+3])) {
-            insertToken(TK_FINISH, "FIM");
-            inputPosition += 3;
-            continue;
-        }
-        
-        if (strncmp(&inputCode[inputPosition], "RES", 3) == 0 && !isAlpha(inputCode[inputPosition+3])) {
-            insertToken(TK_RESULT, "RES");
-            inputPosition += 3;
-            continue;
-        }
-        
-        // Check operators and symbols
-        if (inputCode[inputPosition] == '=') {
-            insertToken(TK_ASSIGN, "=");
-            inputPosition++;
-            continue;
-        }
-        
-        if (inputCode[inputPosition] == '+') {
-            insertToken(TK_ADD, "+");
-            inputPosition++;
-            continue;
-        }
-        
-        if (inputCode[inputPosition] == '-') {
-            insertToken(TK_SUBTRACT, "-");
-            inputPosition++;
-            continue;
-        }
-        
-        if (inputCode[inputPosition] == '*') {
-            insertToken(TK_MULTIPLY, "*");
-            inputPosition++;
-            continue;
-        }
-        
-        if (inputCode[inputPosition] == '/') {
-            insertToken(TK_DIVIDE, "/");
-            inputPosition++;
-            continue;
-        }
-        
-        if (inputCode[inputPosition] == '(') {
-            insertToken(TK_OPEN_BRACKET, "(");
-            inputPosition++;
-            continue;
-        }
-        
-        if (inputCode[inputPosition] == ')') {
-            insertToken(TK_CLOSE_BRACKET, ")");
-            inputPosition++;
-            continue;
-        }
-        
-        if (inputCode[inputPosition] == ':') {
-            insertToken(TK_DELIMITER, ":");
-            inputPosition++;
-            continue;
-        }
-        
-        // Handle quoted string (program name)
-        if (inputCode[inputPosition] == '\"') {
-            inputPosition++; // Skip opening quote
-            int startPos = inputPosition;
-            while (inputCode[inputPosition] != '\"' && inputCode[inputPosition] != '\0')
-                inputPosition++;
-            
-            int length = inputPosition - startPos;
-            char buffer[64];
-            strncpy(buffer, &inputCode[startPos], length);
-            buffer[length] = '\0';
-            insertToken(TK_NAME, buffer);
-            
-            if (inputCode[inputPosition] == '\"')
-                inputPosition++; // Skip closing quote
-            continue;
-        }
-        
-        // Handle identifiers
-        if (isAlpha(inputCode[inputPosition])) {
-            int startPos = inputPosition;
-            while (isAlpha(inputCode[inputPosition]) || isNumeric(inputCode[inputPosition]) || inputCode[inputPosition]=='_')
-                inputPosition++;
-            
-            int length = inputPosition - startPos;
-            char buffer[64];
-            strncpy(buffer, &inputCode[startPos], length);
-            buffer[length] = '\0';
-            insertToken(TK_NAME, buffer);
-            continue;
-        }
-        
-        // Handle numbers
-        if (isNumeric(inputCode[inputPosition])) {
-            int startPos = inputPosition;
-            while (isNumeric(inputCode[inputPosition]))
-                inputPosition++;
-            
-            int length = inputPosition - startPos;
-            char buffer[64];
-            strncpy(buffer, &inputCode[startPos], length);
-            buffer[length] = '\0';
-            insertToken(TK_NUMBER, buffer);
-            continue;
-        }
-        
-        // Skip unrecognized character
-        inputPosition++;
-    }
-    
-    insertToken(TK_END_OF_FILE, "EOF");
-
-    for (int i = 0; i < tokenTotal; i++) {
-        printf("Token[%d]:  Text='%s'\n", i, tokenArray[i].text);
+static void printStats(FILE* out, const char* sourcePath, const NeanderCompileStats* stats, StatsFormat format) {
+    if (format == STATS_JSON) {
+        fprintf(out, "{\"file\": \"");
+        for (const char* c = sourcePath; *c; c++)
+            fprintf(out, *c == '"' || *c == '\\' ? "\\%c" : "%c", *c);
+        fprintf(out, "\", \"phases\": {");
+        for (int i = 0; i < NEANDER_PHASE_COUNT; i++)
+            fprintf(out, "\"%s\": {\"time_ms\": %.3f, \"heap_allocations\": %lu, \"arena_allocations\": %lu, \"heap_bytes\": %zu}%s",
+                    phaseKeys[i], stats->phases[i].milliseconds, stats->phases[i].heap_allocations,
+                    stats->phases[i].arena_allocations, stats->phases[i].heap_bytes,
+                    i + 1 < NEANDER_PHASE_COUNT ? ", " : "");
+        fprintf(out, "}, \"tokens\": %d, \"syntax_nodes\": %d, \"commands\": %d, \"symbols\": {",
+                stats->tokens, stats->syntax_nodes, stats->commands);
+        printSymbolCount(out, "user", &stats->user, false);
+        printSymbolCount(out, "constant", &stats->constants, false);
+        printSymbolCount(out, "temporary", &stats->temporaries, false);
+        printSymbolCount(out, "builtin", &stats->builtins, true);
+        fprintf(out, "}, \"instructions\": %d, \"instruction_limit\": %d, \"data_words\": %d, "
+                     "\"memory_words\": %d, \"memory_word_limit\": %d}\n",
+                stats->instructions, INSTRUCTION_LIMIT, stats->data_words, stats->memory_words, MEMORY_WORD_LIMIT);
+        return;
     }
-}
 
-LexicalToken* peekNextToken() {
-    if (currentIndex < tokenTotal)
-        return &tokenArray[currentIndex];
-    return NULL;
+    fprintf(out, "Estatísticas de %s:\n", sourcePath);
+    fprintf(out, "  %-12s %10s %8s %8s %12s\n", "fase", "tempo (ms)", "heap", "arena", "bytes (heap)");
+    for (int i = 0; i < NEANDER_PHASE_COUNT; i++) {
+        // %-12s pads by bytes; the accented names need it by characters
+        int width = 0;
+        for (const char* c = phaseNames[i]; *c; c++)
+            width += (*c & 0xC0) != 0x80;
+        fprintf(out, "  %s%*s %10.3f %8lu %8lu %12zu\n", phaseNames[i], 12 - width, "",
+                stats->phases[i].milliseconds, stats->phases[i].heap_allocations,
+                stats->phases[i].arena_allocations, stats->phases[i].heap_bytes);
+    }
+    fprintf(out, "  Tokens: %d, nós da AST: %d, comandos: %d\n", stats->tokens, stats->syntax_nodes, stats->commands);
+    fprintf(out, "  Símbolos (na .DATA): usuário %d (%d), constantes %d (%d), temporários %d (%d), internos %d (%d)\n",
+            stats->user.total, stats->user.data, stats->constants.total, stats->constants.data,
+            stats->temporaries.total, stats->temporaries.data, stats->builtins.total, stats->builtins.data);
+    fprintf(out, "  Instruções: %d de %d%s\n", stats->instructions, INSTRUCTION_LIMIT,
+            stats->instructions > INSTRUCTION_LIMIT ? " (excede a área de código)" : "");
+    fprintf(out, "  Palavras de memória: %d de %d (%d de código, %d de dados)%s\n",
+            stats->memory_words, MEMORY_WORD_LIMIT, 2 * stats->instructions, stats->data_words,
+            stats->memory_words > MEMORY_WORD_LIMIT ? " (excede a memória)" : "");
 }
 
-LexicalToken* consumeToken() {
-    if (currentIndex < tokenTotal)
-        return &tokenArray[currentIndex++];
-    return NULL;
-}
-
-/*========================================================================
-  Abstract Syntax Tree (AST) Construction
-========================================================================*/
-typedef enum { NODE_LITERAL, NODE_IDENTIFIER, NODE_OPERATION } NodeCategory;
-
-typedef struct SyntaxNode {
-    NodeCategory category;
-    union {
-        int value;              // for numbers
-        char identifier[64];    // for variables
-        struct {
-            char operator;     // '+', '-', '*', '/'
-            struct SyntaxNode *leftChild;
-            struct SyntaxNode *rightChild;
-        } operation;
-    };
-} SyntaxNode;
-
-SyntaxNode* createLiteralNode(int value) {
-    SyntaxNode* node = malloc(sizeof(SyntaxNode));
-    node->category = NODE_LITERAL;
-    node->value = value;
-    return node;
+static bool failJob(BuildJob* job, const char* errorMessage) {
+    snprintf(job->message, sizeof(job->message), "%s: %s", errorMessage, strerror(errno));
+    return false;
 }
 
-SyntaxNode* createIdentifierNode(const char* name) {
-    SyntaxNode* node = malloc(sizeof(SyntaxNode));
-    node->category = NODE_IDENTIFIER;
-    strncpy(node->identifier, name, sizeof(node->identifier)-1);
-    node->identifier[sizeof(node->identifier)-1] = '\0';
-    return node;
+static bool writeOutput(BuildJob* job, const char* path, const void* data, size_t size, const char* errorMessage) {
+    FILE* output = fopen(path, "wb");
+    if (!output)
+        return failJob(job, errorMessage);
+    bool ok = fwrite(data, 1, size, output) == size;
+    if (fclose(output) != 0 || !ok)
+        return failJob(job, errorMessage);
+    return true;
 }
 
-SyntaxNode* createOperationNode(char operator, SyntaxNode* leftChild, SyntaxNode* rightChild) {
-    SyntaxNode* node = malloc(sizeof(SyntaxNode));
-    node->category = NODE_OPERATION;
-    node->operation.operator = operator;
-    node->operation.leftChild = leftChild;
-    node->operation.rightChild = rightChild;
-    return node;
+// Replays a cached compilation; false (nothing written) if the entry is incomplete
+static bool restoreFromCache(NeanderCache* cache, const BuildSettings* settings, BuildJob* job, FILE* console, bool* written) {
+    size_t logSize = 0, listingSize = 0, binarySize = 0;
+    uint8_t* log = neander_cache_load(cache, "log", &logSize);
+    uint8_t* listing = settings->emitListing ? neander_cache_load(cache, "asm", &listingSize) : NULL;
+    uint8_t* binary = settings->emitBinary ? neander_cache_load(cache, "bin", &binarySize) : NULL;
+    bool complete = log && (!settings->emitListing || listing) && (!settings->emitBinary || binary);
+
+    if (complete) {
+        if (console)
+            fwrite(log, 1, logSize, console);
+        *written = (!settings->emitListing ||
+                    writeOutput(job, job->listingFilename, listing, listingSize, "Erro para criar .asm")) &&
+                   (!settings->emitBinary ||
+                    writeOutput(job, job->binaryFilename, binary, binarySize, "Erro para criar .bin"));
+    }
+    free(log);
+    free(listing);
+    free(binary);
+    return complete;
 }
 
-/* Recursive parsing functions for expressions */
-SyntaxNode* parseExpression();
-SyntaxNode* parseTerm();
-SyntaxNode* parseFactor();
+/*
+ * Compiles one source into its .asm/.bin. The progress log goes to console
+ * (NULL = discarded); errors are left in job->message for the caller.
+ */
+static bool buildFile(const BuildSettings* settings, BuildJob* job, FILE* console) {
+    FILE* inputFile = fopen(job->sourcePath, "r");
+    if (!inputFile)
+        return failJob(job, "Erro para abrir .lpn");
 
-SyntaxNode* parseExpression() {
-    SyntaxNode* node = parseTerm();
-    LexicalToken* token;
-    
-    while ((token = peekNextToken()) && (token->category == TK_ADD || token->category == TK_SUBTRACT)) {
-        token = consumeToken(); // consume the operator
-        SyntaxNode* rightNode = parseTerm();
-        node = createOperationNode(token->text[0], node, rightNode);
-    }
-    return node;
-}
+    // Determine file size for buffer allocation
+    fseek(inputFile, 0, SEEK_END);
+    long fileSize = ftell(inputFile);
+    fseek(inputFile, 0, SEEK_SET);
 
-SyntaxNode* parseTerm() {
-    SyntaxNode* node = parseFactor();
-    LexicalToken* token;
-    
-    while ((token = peekNextToken()) && (token->category == TK_MULTIPLY || token->category == TK_DIVIDE)) {
-        token = consumeToken(); // consume the operator
-        SyntaxNode* rightNode = parseFactor();
-        node = createOperationNode(token->text[0], node, rightNode);
+    char* source = malloc(fileSize > 0 ? fileSize : 1);
+    if (!source) {
+        fclose(inputFile);
+        return failJob(job, "Erro na alocação de memória");
     }
-    return node;
-}
+    size_t bytesRead = fread(source, 1, fileSize, inputFile);
+    fclose(inputFile);
 
-SyntaxNode* parseFactor() {
-    LexicalToken* token = peekNextToken();
-    if (!token) return NULL;
-    
-    if (token->category == TK_OPEN_BRACKET) {
-        consumeToken(); // consume '('
-        SyntaxNode* node = parseExpression();
-        consumeToken(); // consume ')'
-        return node;
-    }
-    
-    if (token->category == TK_NUMBER) {
-        token = consumeToken();
-        return createLiteralNode(atoi(token->text));
-    }
-    
-    if (token->category == TK_NAME) {
-        token = consumeToken();
-        return createIdentifierNode(token->text);
+    // Output names: the source path with .asm / .bin in place of its extension
+    strncpy(job->listingFilename, job->sourcePath, sizeof(job->listingFilename)-5);
+    job->listingFilename[sizeof(job->listingFilename)-5] = '\0';
+    char* dot = strrchr(job->listingFilename, '.');
+    char* slash = strrchr(job->listingFilename, '/');
+    if (dot && (!slash || dot > slash)) *dot = '\0';
+    strcpy(job->binaryFilename, job->listingFilename);
+    strcat(job->listingFilename, ".asm");
+    strcat(job->binaryFilename, ".bin");
+
+    // The key covers everything the outputs depend on: build, options and source bytes
+    NeanderCache cache;
+    bool useCache = settings->useCache;
+    if (useCache && !neander_cache_open(&cache, settings->cacheDir)) {
+        fprintf(stderr, "Aviso: cache indisponível em %s; compilando sem cache\n",
+                settings->cacheDir ? settings->cacheDir : neander_cache_dir());
+        useCache = false;
+    }
+    if (useCache) {
+        char key[96];
+        snprintf(key, sizeof(key), "optimize=%d propagate=%d asm=%d bin=%d", settings->options.optimize,
+                 settings->options.propagate, settings->emitListing, settings->emitBinary);
+        neander_cache_key(&cache, "compilador " NEANDER_BUILD_ID, key, source, bytesRead);
+        bool written;
+        if (neander_cache_lookup(&cache) && restoreFromCache(&cache, settings, job, console, &written)) {
+            free(source);
+            job->cacheHit = true;
+            return written;
+        }
     }
-    
-    return NULL;
-}
 
-/*========================================================================
-  Statement Representation
-========================================================================*/
-typedef struct Command {
-    char variable[64];
-    SyntaxNode* expression;
-    struct Command* next;
-} Command;
-
-Command* commandList = NULL;
-Command* lastCommand = NULL;
-
-void parseAssignmentStmt() {
-    LexicalToken* token = consumeToken(); // expect identifier
-    if (!token || token->category != TK_NAME) {
-        printf("Warning: Esperado identificador\n");
-        return;
-    }
-    
-    char varName[64];
-    strncpy(varName, token->text, sizeof(varName));
-    
-    LexicalToken* equals = consumeToken(); // expect '='
-    if (!equals || equals->category != TK_ASSIGN) {
-        printf("Esperado '='\n");
-        return;
-    }
-    
-    SyntaxNode* expr = parseExpression();
-    
-    Command* cmd = malloc(sizeof(Command));
-    strncpy(cmd->variable, varName, sizeof(cmd->variable));
-    cmd->expression = expr;
-    cmd->next = NULL;
-    
-    if (commandList == NULL) {
-        commandList = cmd;
-        lastCommand = cmd;
-    } else {
-        lastCommand->next = cmd;
-        lastCommand = cmd;
-    }
-    
+    // With the cache on, the progress log is captured so a hit can replay it
+    NeanderCompileOptions options = settings->options;
+    char* logText = NULL;
+    size_t logSize = 0;
+    options.log = console;
+    if (useCache && !(options.log = open_memstream(&logText, &logSize))) {
+        options.log = console;
+        useCache = false;
+    }
+
+    NeanderCompiler* compiler = neander_compiler_new(&options);
+    bool compiled = neander_compile(compiler, source, bytesRead);
+    free(source);
+    if (settings->stats != STATS_NONE) {
+        neander_compiler_stats(compiler, &job->stats);
+        job->hasStats = true;
+    }
+    if (useCache) {
+        fclose(options.log);
+        if (console)
+            fwrite(logText, 1, logSize, console);
+    }
+    if (!compiled) {
+        snprintf(job->message, sizeof(job->message), "%s", neander_compiler_error(compiler));
+        job->compileFailed = true;
+        neander_compiler_free(compiler);
+        free(logText);
+        return false;
+    }
+    
+    bool ok = true;
+    char* listing = NULL;
+    size_t listingSize = 0;
+    if (settings->emitListing) {
+        FILE* listingStream = open_memstream(&listing, &listingSize);
+        neander_compiler_write_listing(compiler, listingStream);
+        fclose(listingStream);
+        ok = writeOutput(job, job->listingFilename, listing, listingSize, "Erro para criar .asm");
+    }
+    
+    uint8_t* binary = NULL;
+    size_t binarySize = 0;
+    if (settings->emitBinary && ok) {
+        NeanderAssembler image;
+        if (!neander_compiler_image(compiler, &image)) {
+            snprintf(job->message, sizeof(job->message), "%s", image.error);
+            ok = false;
+        } else {
+            binary = neander_image_v2(&image, &binarySize);
+            ok = writeOutput(job, job->binaryFilename, binary, binarySize, "Erro para criar .bin");
+        }
+        neander_free(&image);
+    }
+    neander_compiler_free(compiler);
+
+    // A failed store only costs the next run a recompilation
+    if (useCache && ok) {
+        neander_cache_begin(&cache);
+        neander_cache_put(&cache, "log", logText, logSize);
+        if (settings->emitListing)
+            neander_cache_put(&cache, "asm", listing, listingSize);
+        if (settings->emitBinary)
+            neander_cache_put(&cache, "bin", binary, binarySize);
+        neander_cache_commit(&cache);
+    }
+    free(logText);
+    free(listing);
+    free(binary);
+    return ok;
 }
 
-/* Program structure representation */
+// Build driver: a shared queue of sources drained by the worker threads
 typedef struct {
-    char title[64];
-    Command* commands;
-    SyntaxNode* output;
-} CompilationUnit;
-
-CompilationUnit program;
-
-void freeNode(SyntaxNode* node) {
-    if (!node) return;
-    if (node->category == NODE_OPERATION) {
-        freeNode(node->operation.leftChild);
-        freeNode(node->operation.rightChild);
-    }
-    free(node);
-}
-
-void freeCommands(Command* cmd) {
-    while (cmd) {
-        Command* next = cmd->next;
-        freeNode(cmd->expression);
-        free(cmd);
-        cmd = next;
-    }
-}
-
-/*========================================================================
-  Program Parsing (according to grammar)
-  
-  Format:
-    PROGRAMA "Name" :
-    INICIO
-      <assignments>
-      RES = <expression>
-    FIM
-========================================================================*/
-void parseProgram() {
-    LexicalToken* token = consumeToken(); // Should be PROGRAMA
-    if (!token || token->category != TK_START) { 
-        printf("Erro: Esperado PROGRAMA no cabeçalho (consultar gramatica.pdf)\n"); 
-        exit(1); 
-    }
-    
-    token = consumeToken(); // Program name (in quotes)
-    if (!token || token->category != TK_NAME) { 
-        printf("Erro: Esperado NOME DO PROGRAMA no cabeçalho (consultar gramatica.pdf)\n"); 
-        exit(1); 
-    }
-    strncpy(program.title, token->text, sizeof(program.title));
-    
-    token = consumeToken(); // Should be ":"
-    if (!token || token->category != TK_DELIMITER) { 
-        exit(1); 
-    }
-    
-    token = consumeToken(); // Should be INICIO
-    if (!token || token->category != TK_BEGIN) { 
-        printf("Erro: Esperado INICIO no código (consultar gramatica.pdf)\n"); 
-        exit(1); 
-    }
-    
-    // Process assignments until we find RES
-    while (1) {
-        token = peekNextToken();
-        if (!token) break;
-        if (token->category == TK_RESULT)
+    const BuildSettings* settings;
+    BuildJob* jobs;
+    size_t count;
+    size_t next;
+    size_t failures;
+    pthread_mutex_t lock;
+} BuildQueue;
+
+static void* buildWorker(void* argument) {
+    BuildQueue* queue = argument;
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        size_t i = queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+        if (i >= queue->count)
             break;
-        parseAssignmentStmt();
-    }
-    
-    token = consumeToken(); // Should be RES
-    if (!token || token->category != TK_RESULT) { 
-        printf("Erro: Esperado RES para armazenar o retorno do programa (consultar gramatica.pdf)\n"); 
-        exit(1); 
-    }
-    
-    token = consumeToken(); // Should be '='
-    if (!token || token->category != TK_ASSIGN) { 
-        printf("Erro: Esperado '=' após RES (consultar gramatica.pdf)\n"); 
-        exit(1); 
-    }
-    
-    program.output = parseExpression();
-    
-    token = consumeToken(); // Should be FIM
-    if (!token || token->category != TK_FINISH) { 
-        printf("Erro: Esperado FIM para finalizar o programa (consultar gramatica.pdf)\n"); 
-        exit(1); 
-    }
-}
-
-/*========================================================================
-  Symbol Table for Assembly Generation
-========================================================================*/
-typedef struct {
-    char identifier[64];
-    int data;
-    bool initialized;
-} Symbol;
-
-#define SYMTABLE_SIZE 256
-Symbol symbolTable[SYMTABLE_SIZE];
-int symbolCount = 0;
-
-int addSymbol(const char* identifier) {
-    // Check if symbol already exists
-    for (int i = 0; i < symbolCount; i++) {
-        if (strcmp(symbolTable[i].identifier, identifier) == 0)
-            return i;
-    }
-    
-    // Add new symbol
-    strncpy(symbolTable[symbolCount].identifier, identifier, sizeof(symbolTable[symbolCount].identifier)-1);
-    symbolTable[symbolCount].identifier[sizeof(symbolTable[symbolCount].identifier)-1] = '\0';
-    symbolTable[symbolCount].data = 0;
-    symbolTable[symbolCount].initialized = false;
-    symbolCount++;
-    return symbolCount - 1;
-}
 
-/* Update symbol value if expression is a literal */
-void updateSymbolValue(const char* identifier, int value) {
-    for (int i = 0; i < symbolCount; i++) {
-        if (strcmp(symbolTable[i].identifier, identifier) == 0) {
-            symbolTable[i].data = value;
-            symbolTable[i].initialized = true;
-            return;
+        BuildJob* job = &queue->jobs[i];
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bool ok = buildFile(queue->settings, job, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        job->milliseconds = elapsedMilliseconds(&start, &end);
+        job->message[strcspn(job->message, "\n")] = '\0';  // one line per file
+
+        pthread_mutex_lock(&queue->lock);
+        if (ok)
+            printf("[ok] %s -> %s%s%s (%.3f ms%s)\n", job->sourcePath,
+                   queue->settings->emitListing ? job->listingFilename : "",
+                   queue->settings->emitListing && queue->settings->emitBinary ? ", " : "",
+                   queue->settings->emitBinary ? job->binaryFilename : "",
+                   job->milliseconds, job->cacheHit ? ", cache" : "");
+        else {
+            printf("[erro] %s: %s (%.3f ms)\n", job->sourcePath,
+                   job->message[0] ? job->message : "Erro de compilação", job->milliseconds);
+            queue->failures++;
         }
+        if (job->hasStats)
+            printStats(stderr, job->sourcePath, &job->stats, queue->settings->stats);
+        pthread_mutex_unlock(&queue->lock);
     }
-    
-    // Symbol not found, add it first
-    addSymbol(identifier);
-    updateSymbolValue(identifier, value);
-}
-
-// Register numeric constants in symbol table
-void registerConstant(int value) {
-    char constName[64];
-    sprintf(constName, "CONST_%d", value);
-    
-    // Check if constant already exists
-    for (int i = 0; i < symbolCount; i++) {
-        if (strcmp(symbolTable[i].identifier, constName) == 0)
-            return; // Already registered
-    }
-    
-    // Add new constant
-    addSymbol(constName);
-    updateSymbolValue(constName, value);
+    return NULL;
 }
 
-int tempVarCount = 0;
-char tempVarName[64];
-
-void createTempVar(char* buffer) {
-    sprintf(buffer, "TEMP_%d", tempVarCount++);
-    addSymbol(buffer);
+static int compareSources(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
 }
 
-FILE* asmOutput;
-
-// Function declarations to avoid compilation errors
-void generateExprCode(SyntaxNode* node);
-void generateAssignmentCode(Command* cmd);
-void generateAssemblyCode();
-
-// Improved function for code generation from expressions
-void generateExprCode(SyntaxNode* node) {
-    if (node->category == NODE_LITERAL) {
-        // Ensure constant exists in symbol table
-        char constName[64];
-        sprintf(constName, "CONST_%d", node->value);
-        registerConstant(node->value);
-        fprintf(asmOutput, "LDA %s\n", constName);
-    } 
-    else if (node->category == NODE_IDENTIFIER) {
-        addSymbol(node->identifier);
-        fprintf(asmOutput, "LDA %s\n", node->identifier);
-    } 
-    else if (node->category == NODE_OPERATION) {
-        char op = node->operation.operator;
-        
-        if (op == '+') {
-            // Handle addition cases
-            if (node->operation.leftChild->category == NODE_IDENTIFIER && 
-                node->operation.rightChild->category == NODE_IDENTIFIER) {
-                // Simple case: id + id
-                fprintf(asmOutput, "LDA %s\n", node->operation.leftChild->identifier);
-                fprintf(asmOutput, "ADD %s\n", node->operation.rightChild->identifier);
-            } 
-            else if (node->operation.leftChild->category == NODE_IDENTIFIER && 
-                     node->operation.rightChild->category == NODE_LITERAL) {
-                // Case: id + number
-                char constName[64];
-                sprintf(constName, "CONST_%d", node->operation.rightChild->value);
-                registerConstant(node->operation.rightChild->value);
-                fprintf(asmOutput, "LDA %s\n", node->operation.leftChild->identifier);
-                fprintf(asmOutput, "ADD %s\n", constName);
-            } 
-            else if (node->operation.leftChild->category == NODE_LITERAL && 
-                     node->operation.rightChild->category == NODE_IDENTIFIER) {
-                // Case: number + id
-                char constName[64];
-                sprintf(constName, "CONST_%d", node->operation.leftChild->value);
-                registerConstant(node->operation.leftChild->value);
-                fprintf(asmOutput, "LDA %s\n", constName);
-                fprintf(asmOutput, "ADD %s\n", node->operation.rightChild->identifier);
-            } 
-            else if (node->operation.leftChild->category == NODE_LITERAL && 
-                     node->operation.rightChild->category == NODE_LITERAL) {
-                // Case: number + number (optimize at compile time)
-                int result = node->operation.leftChild->value + node->operation.rightChild->value;
-                char constName[64];
-                sprintf(constName, "CONST_%d", result);
-                registerConstant(result);
-                fprintf(asmOutput, "LDA %s\n", constName);
-            } 
-            else {
-                // Complex case with subexpressions
-                generateExprCode(node->operation.leftChild);  // Load left side
-                
-                // If right side is simple, add directly
-                if (node->operation.rightChild->category == NODE_IDENTIFIER) {
-                    fprintf(asmOutput, "ADD %s\n", node->operation.rightChild->identifier);
-                } 
-                else if (node->operation.rightChild->category == NODE_LITERAL) {
-                    char constName[64];
-                    sprintf(constName, "CONST_%d", node->operation.rightChild->value);
-                    registerConstant(node->operation.rightChild->value);
-                    fprintf(asmOutput, "ADD %s\n", constName);
-                } 
-                else {
-                    // Right side is complex, store left result
-                    createTempVar(tempVarName);
-                    fprintf(asmOutput, "STA %s\n", tempVarName);
-                    
-                    // Evaluate right side
-                    generateExprCode(node->operation.rightChild);
-                    
-                    // Add left result
-                    fprintf(asmOutput, "ADD %s\n", tempVarName);
-                }
-            }
-        } 
-        else if (op == '-') {
-            // Handle subtraction cases
-            if (node->operation.leftChild->category == NODE_IDENTIFIER && 
-                node->operation.rightChild->category == NODE_IDENTIFIER) {
-                // Simple case: id - id
-                fprintf(asmOutput, "LDA %s\n", node->operation.leftChild->identifier);
-                fprintf(asmOutput, "SUB %s\n", node->operation.rightChild->identifier);
-            } 
-            else if (node->operation.leftChild->category == NODE_IDENTIFIER && 
-                     node->operation.rightChild->category == NODE_LITERAL) {
-                // Case: id - number
-                char constName[64];
-                sprintf(constName, "CONST_%d", node->operation.rightChild->value);
-                registerConstant(node->operation.rightChild->value);
-                fprintf(asmOutput, "LDA %s\n", node->operation.leftChild->identifier);
-                fprintf(asmOutput, "SUB %s\n", constName);
-            } 
-            else if (node->operation.leftChild->category == NODE_LITERAL && 
-                     node->operation.rightChild->category == NODE_IDENTIFIER) {
-                // Case: number - id
-                char constName[64];
-                sprintf(constName, "CONST_%d", node->operation.leftChild->value);
-                registerConstant(node->operation.leftChild->value);
-                fprintf(asmOutput, "LDA %s\n", constName);
-                fprintf(asmOutput, "SUB %s\n", node->operation.rightChild->identifier);
-            } 
-            else if (node->operation.leftChild->category == NODE_LITERAL && 
-                     node->operation.rightChild->category == NODE_LITERAL) {
-                // Case: number - number (optimize at compile time)
-                int result = node->operation.leftChild->value - node->operation.rightChild->value;
-                char constName[64];
-                sprintf(constName, "CONST_%d", result);
-                registerConstant(result);
-                fprintf(asmOutput, "LDA %s\n", constName);
-            } 
-            else {
-                // Complex case with subexpressions
-                generateExprCode(node->operation.leftChild);  // Load left side
-                
-                // If right side is simple, subtract directly
-                if (node->operation.rightChild->category == NODE_IDENTIFIER) {
-                    fprintf(asmOutput, "SUB %s\n", node->operation.rightChild->identifier);
-                } 
-                else if (node->operation.rightChild->category == NODE_LITERAL) {
-                    char constName[64];
-                    sprintf(constName, "CONST_%d", node->operation.rightChild->value);
-                    registerConstant(node->operation.rightChild->value);
-                    fprintf(asmOutput, "SUB %s\n", constName);
-                } 
-                else {
-                    // Right side is complex, store left result
-                    createTempVar(tempVarName);
-                    fprintf(asmOutput, "STA %s\n", tempVarName);
-                    
-                    // Evaluate right side
-                    generateExprCode(node->operation.rightChild);
-                    
-                    // Store right result
-                    char rightTemp[64];
-                    createTempVar(rightTemp);
-                    fprintf(asmOutput, "STA %s\n", rightTemp);
-                    
-                    // Load left and subtract right
-                    fprintf(asmOutput, "LDA %s\n", tempVarName);
-                    fprintf(asmOutput, "SUB %s\n", rightTemp);
-                }
-            }
-        } 
-        else if (op == '*') {
-            // Handle multiplication
-            char resultTemp[64];
-            createTempVar(resultTemp); // For storing the result
-            fprintf(asmOutput, "LDA CONST_0\n"); // Start with zero
-            fprintf(asmOutput, "STA %s\n", resultTemp);
-
-            if (node->operation.rightChild->category == NODE_LITERAL) {
-                // Multiplier is a literal number
-                int multiplier = node->operation.rightChild->value;
-                for (int i = 0; i < multiplier; i++) {
-                    generateExprCode(node->operation.leftChild); // Load left operand
-                    fprintf(asmOutput, "ADD %s\n", resultTemp);
-                    fprintf(asmOutput, "STA %s\n", resultTemp);
-                }
-            } 
-            else if (node->operation.rightChild->category == NODE_IDENTIFIER) {
-                // Multiplier is a variable
-                // Check if variable has a known value
-                int multiplier = -1;
-                for (int i = 0; i < symbolCount; i++) {
-                    if (strcmp(symbolTable[i].identifier, node->operation.rightChild->identifier) == 0 && 
-                        symbolTable[i].initialized) {
-                        multiplier = symbolTable[i].data;
-                        break;
-                    }
-                }
-                
-                if (multiplier >= 0) {
-                    // Use the known value
-                    for (int i = 0; i < multiplier; i++) {
-                        generateExprCode(node->operation.leftChild); // Load left operand
-                        fprintf(asmOutput, "ADD %s\n", resultTemp);
-                        fprintf(asmOutput, "STA %s\n", resultTemp);
-                    }
-                } 
-                else {
-                    // Unknown value, display warning
-                    fprintf(asmOutput, "; Warning: Multiplication with dynamic variable %s\n", 
-                            node->operation.rightChild->identifier);
-                    fprintf(asmOutput, "LDA CONST_0\n");
-                    printf("Warning: Multiplication with unknown value in %s\n", 
-                           node->operation.rightChild->identifier);
-                }
-            }
-            
-            fprintf(asmOutput, "LDA %s\n", resultTemp); // Load final result
-        } 
-        else if (op == '/') {
-            if (node->operation.leftChild->category == NODE_LITERAL && 
-                node->operation.rightChild->category == NODE_LITERAL) {
-                
-                // Check for division by zero
-                if (node->operation.rightChild->value == 0) {
-                    fprintf(stderr, "Erro: Divisão por 0 detectada\n");
-                    fprintf(asmOutput, "; Erro: Divisão por 0\n");
-                    fprintf(asmOutput, "LDA CONST_0\n");
-                    return;
-                }
-                
-                // Optimize constant division
-                int result = node->operation.leftChild->value / node->operation.rightChild->value;
-                char constName[64];
-                sprintf(constName, "CONST_%d", result);
-                registerConstant(result);
-                fprintf(asmOutput, "LDA %s\n", constName);
-            } 
-            else {
-                // General division algorithm
-                char quotient[64], dividend[64], divisor[64];
-                createTempVar(quotient);   // For result
-                createTempVar(dividend);   // For dividend (working copy)
-                createTempVar(divisor);    // For divisor
-        
-                // Initialize quotient with 0
-                fprintf(asmOutput, "LDA CONST_0\n");
-                fprintf(asmOutput, "STA %s\n", quotient);
-        
-                // Load dividend
-                if (node->operation.leftChild->category == NODE_LITERAL) {
-                    char constName[64];
-                    sprintf(constName, "CONST_%d", node->operation.leftChild->value);
-                    registerConstant(node->operation.leftChild->value);
-                    fprintf(asmOutput, "LDA %s\n", constName);
-                } 
-                else if (node->operation.leftChild->category == NODE_IDENTIFIER) {
-                    fprintf(asmOutput, "LDA %s\n", node->operation.leftChild->identifier);
-                } 
-                else {
-                    generateExprCode(node->operation.leftChild);
-                }
-                fprintf(asmOutput, "STA %s\n", dividend);
-        
-                // Load divisor
-                if (node->operation.rightChild->category == NODE_LITERAL) {
-                    if (node->operation.rightChild->value == 0) {
-                        fprintf(stderr, "Erro: Divisão por 0 detectada\n");
-                        fprintf(asmOutput, "; Erro: Division by zero\n");
-                        fprintf(asmOutput, "LDA CONST_0\n");
-                        return;
-                    }
-                    char constName[64];
-                    sprintf(constName, "CONST_%d", node->operation.rightChild->value);
-                    registerConstant(node->operation.rightChild->value);
-                    fprintf(asmOutput, "LDA %s\n", constName);
-                } 
-                else if (node->operation.rightChild->category == NODE_IDENTIFIER) {
-                    fprintf(asmOutput, "LDA %s\n", node->operation.rightChild->identifier);
-                } 
-                else {
-                    generateExprCode(node->operation.rightChild);
-                }
-                fprintf(asmOutput, "STA %s\n", divisor);
-        
-                // Ensure CONST_1 exists
-                registerConstant(1);
-        
-                // Create unique labels for division loop
-                static int divLabelCount = 0;
-                char divLoop[64], divEnd[64];
-                sprintf(divLoop, "DIV_LOOP_%d", divLabelCount);
-                sprintf(divEnd, "DIV_DONE_%d", divLabelCount++);
-        
-                // Division loop implementation
-                fprintf(asmOutput, "%s:\n", divLoop);
-                fprintf(asmOutput, "LDA %s\n", dividend);
-                fprintf(asmOutput, "SUB %s\n", divisor);
-                fprintf(asmOutput, "JMN %s\n", divEnd); // Exit if negative
-                fprintf(asmOutput, "STA %s\n", dividend); // Update dividend
-                fprintf(asmOutput, "LDA %s\n", quotient);
-                fprintf(asmOutput, "ADD CONST_1\n");
-                fprintf(asmOutput, "STA %s\n", quotient);
-                fprintf(asmOutput, "JMP %s\n", divLoop);
-                fprintf(asmOutput, "%s:\n", divEnd);
-        
-                // Load final quotient
-                fprintf(asmOutput, "LDA %s\n", quotient);
+// A directory contributes its *.lpn files, in name order
+static bool collectSources(const char* path, char*** sources, size_t* count, size_t* capacity) {
+    struct stat info;
+    bool directory = stat(path, &info) == 0 && S_ISDIR(info.st_mode);
+    size_t first = *count;
+
+    DIR* dir = directory ? opendir(path) : NULL;
+    if (directory && !dir) {
+        perror("Erro ao abrir diretório");
+        return false;
+    }
+    for (struct dirent* entry; ; ) {
+        char file[PATH_MAX];
+        if (dir) {
+            if (!(entry = readdir(dir)))
+                break;
+            size_t length = strlen(entry->d_name);
+            if (length < 4 || strcmp(entry->d_name + length - 4, ".lpn") != 0)
+                continue;
+            snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+        }
+        if (*count == *capacity) {
+            *capacity = *capacity ? *capacity * 2 : 64;
+            *sources = realloc(*sources, *capacity * sizeof(char*));
+            if (!*sources) {
+                perror("Erro na alocação de memória");
+                exit(1);
             }
         }
+        (*sources)[(*count)++] = strdup(dir ? file : path);
+        if (!dir)
+            break;
     }
-}
-
-void generateAssignmentCode(Command* cmd) {
-    // If assignment is a literal number, update symbol value directly
-    if (cmd->expression && cmd->expression->category == NODE_LITERAL) {
-        updateSymbolValue(cmd->variable, cmd->expression->value);
-        // Generate direct assignment code
-        char constName[64];
-        sprintf(constName, "CONST_%d", cmd->expression->value);
-        registerConstant(cmd->expression->value);
-        fprintf(asmOutput, "LDA %s\n", constName);
-        fprintf(asmOutput, "STA %s\n", cmd->variable);
-    } else {
-        // For complex expressions, generate normal code
-        generateExprCode(cmd->expression);
-        addSymbol(cmd->variable);
-        fprintf(asmOutput, "STA %s\n", cmd->variable);
+    if (dir) {
+        closedir(dir);
+        qsort(*sources + first, *count - first, sizeof(char*), compareSources);
     }
+    return true;
 }
 
-void generateAssemblyCode() {
-    fprintf(asmOutput, "; Assembly code generated by compiler\n");
-    fprintf(asmOutput, "; Program: %s\n\n", program.title);
-    
-    fprintf(asmOutput, ".DATA\n");
-    /* Fixed header */
-    fprintf(asmOutput, "UNITY DB 1\n");
-    fprintf(asmOutput, "CONST_0 DB 0\n");
-    fprintf(asmOutput, "CONST_1 DB 1\n");
-    fprintf(asmOutput, "NEGATIVE DB 255\n");
-    fprintf(asmOutput, "RESULT DB ?\n");
-    
-    /* Pre-processing to ensure all constants are defined */
-    Command* cmd = commandList;
-    while (cmd) {
-        if (cmd->expression && cmd->expression->category == NODE_LITERAL) {
-            registerConstant(cmd->expression->value);
-        }
-        cmd = cmd->next;
+static int runDriver(const BuildSettings* settings, char** sources, size_t count, long jobs) {
+    BuildQueue queue = { .settings = settings, .count = count };
+    queue.jobs = calloc(count ? count : 1, sizeof(BuildJob));
+    if (!queue.jobs) {
+        perror("Erro na alocação de memória");
+        return 1;
     }
-    
-    /* Print symbols from table */
-    for (int i = 0; i < symbolCount; i++) {
-        if (strcmp(symbolTable[i].identifier, "UNITY") == 0 ||
-            strcmp(symbolTable[i].identifier, "CONST_0") == 0 ||
-            strcmp(symbolTable[i].identifier, "CONST_1") == 0 ||
-            strcmp(symbolTable[i].identifier, "NEGATIVE") == 0 ||
-            strcmp(symbolTable[i].identifier, "RESULT") == 0)
-            continue;
-        
-        if (strncmp(symbolTable[i].identifier, "TEMP_", 5) == 0) {
-            fprintf(asmOutput, "%s DB ?\n", symbolTable[i].identifier);
-        } else if (strncmp(symbolTable[i].identifier, "CONST_", 6) == 0) {
-            fprintf(asmOutput, "%s DB %d\n", symbolTable[i].identifier, symbolTable[i].data);
-        } else if (!symbolTable[i].initialized) {
-            fprintf(asmOutput, "%s DB ?\n", symbolTable[i].identifier);
-        } else {
-            fprintf(asmOutput, "%s DB %d\n", symbolTable[i].identifier, symbolTable[i].data);
+    for (size_t i = 0; i < count; i++)
+        queue.jobs[i].sourcePath = sources[i];
+    pthread_mutex_init(&queue.lock, NULL);
+
+    if (jobs < 1) jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (jobs < 1) jobs = 1;
+    if ((size_t)jobs > count && count > 0) jobs = (long)count;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_t* threads = calloc((size_t)jobs, sizeof(pthread_t));
+    long started = 0;
+    for (long i = 0; i < jobs; i++) {
+        if (pthread_create(&threads[i], NULL, buildWorker, &queue) != 0) {
+            // Out of threads: the main thread drains the queue alongside the ones running
+            fprintf(stderr, "Aviso: só %ld de %ld threads criadas\n", started, jobs);
+            buildWorker(&queue);
+            jobs = started + 1;
+            break;
         }
-    }
-    
-    fprintf(asmOutput, "\n.CODE\n");
-    fprintf(asmOutput, ".ORG 0\n");
-    
-    /* Generate instructions for assignments */
-    cmd = commandList;
-    while (cmd) {
-        fprintf(asmOutput, "; Assignment: %s = ...\n", cmd->variable);
-        generateAssignmentCode(cmd);
-        cmd = cmd->next;
-    }
-    
-    /* Generate code for final expression */
-    fprintf(asmOutput, "; Result expression\n");
-    generateExprCode(program.output);
-    fprintf(asmOutput, "STA RESULT\n");
-    fprintf(asmOutput, "HALT\n");
-    
-    printf("Código assembly gerado!\n");
+        started++;
+    }
+    for (long i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double busy = 0;
+    for (size_t i = 0; i < count; i++)
+        busy += queue.jobs[i].milliseconds;
+    fflush(stdout);
+    fprintf(stderr, "Compilação: %zu arquivos, %zu falhas, %ld threads, %.3f ms (%.3f ms somando os arquivos)\n",
+            count, queue.failures, jobs, elapsedMilliseconds(&start, &end), busy);
+
+    free(threads);
+    free(queue.jobs);
+    pthread_mutex_destroy(&queue.lock);
+    return queue.failures || count == 0 ? 1 : 0;
 }
 
 int main(int argc, char **argv) {
-    if (argc < 2) {
-        printf("Usage: %s sourcefile.lpn\n", argv[0]);
-        return 1;
+    BuildSettings settings = {
+        .options = { .optimize = true, .propagate = true, .log = stdout },
+        .emitListing = true,
+        .useCache = getenv("NEANDER_CACHE_DIR") != NULL,
+    };
+    bool emitChosen = false;
+    bool showCacheStats = false;
+    bool driver = false;
+    long jobs = 0;
+    char** sources = NULL;
+    size_t sourceCount = 0, sourceCapacity = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-opt") == 0)
+            settings.options.optimize = false;
+        else if (strcmp(argv[i], "--no-propagate") == 0)
+            settings.options.propagate = false;
+        else if (strcmp(argv[i], "--emit=asm") == 0) {
+            settings.emitListing = true;
+            settings.emitBinary = false;
+            emitChosen = true;
+        }
+        else if (strcmp(argv[i], "--emit=bin") == 0) {
+            settings.emitListing = false;
+            settings.emitBinary = true;
+            emitChosen = true;
+        }
+        else if (strcmp(argv[i], "--emit=both") == 0) {
+            settings.emitListing = true;
+            settings.emitBinary = true;
+            emitChosen = true;
+        }
+        else if (strcmp(argv[i], "--cache") == 0)
+            settings.useCache = true;
+        else if (strncmp(argv[i], "--cache=", 8) == 0) {
+            settings.useCache = true;
+            settings.cacheDir = argv[i] + 8;
+        }
+        else if (strcmp(argv[i], "--no-cache") == 0)
+            settings.useCache = false;
+        else if (strcmp(argv[i], "--cache-stats") == 0)
+            showCacheStats = true;
+        else if (strcmp(argv[i], "--stats") == 0 || strcmp(argv[i], "--stats=text") == 0)
+            settings.stats = STATS_TEXT;
+        else if (strcmp(argv[i], "--stats=json") == 0)
+            settings.stats = STATS_JSON;
+        else if (strncmp(argv[i], "--jobs=", 7) == 0) {
+            jobs = atol(argv[i] + 7);
+            driver = true;
+        }
+        else {
+            struct stat info;
+            if (stat(argv[i], &info) == 0 && S_ISDIR(info.st_mode))
+                driver = true;
+            if (!collectSources(argv[i], &sources, &sourceCount, &sourceCapacity))
+                return 1;
+        }
     }
 
-    FILE* inputFile = fopen(argv[1], "r");
-    if (!inputFile) {
-        perror("Erro para abrir .lpn");
-        return 1;
+    if (sourceCount == 0 && showCacheStats) {
+        neander_cache_print_stats(settings.cacheDir, stdout);
+        return 0;
     }
-
-    // Determine file size for buffer allocation
-    fseek(inputFile, 0, SEEK_END);
-    long fileSize = ftell(inputFile);
-    fseek(inputFile, 0, SEEK_SET);
-
-    // Allocate memory for file content
-    inputCode = (char*)malloc(fileSize + 1);
-    if (!inputCode) {
-        perror("Erro na alocação de memória");
-        fclose(inputFile);
+    if (sourceCount == 0 && !driver) {
+        printf("Usage: %s [--no-opt] [--no-propagate] [--emit=asm|bin|both] [--cache[=dir]] [--no-cache] [--cache-stats]\n"
+               "       [--stats[=text|json]] [--jobs=N] sourcefile.lpn... | directory\n", argv[0]);
         return 1;
     }
 
-    // Read file into buffer
-    size_t bytesRead = fread(inputCode, 1, fileSize, inputFile);
-    inputCode[bytesRead] = '\0';
-    fclose(inputFile);
+    // Statistics describe an actual compilation, which a cache hit skips
+    if (settings.stats != STATS_NONE)
+        settings.useCache = false;
 
-    // Create output .asm file
-    char outputFilename[256];
-    strncpy(outputFilename, argv[1], sizeof(outputFilename)-5);
-    outputFilename[sizeof(outputFilename)-5] = '\0';
-    char* dot = strrchr(outputFilename, '.');
-    if (dot) *dot = '\0';
-    strcat(outputFilename, ".asm");
-    
-    asmOutput = fopen(outputFilename, "w");
-    if (!asmOutput) {
-        perror("Erro para criar .asm");
-        free(inputCode);
-        return 1;
+    int status;
+    if (driver || sourceCount > 1) {
+        // The driver compiles and assembles unless told otherwise
+        if (!emitChosen)
+            settings.emitBinary = true;
+        status = runDriver(&settings, sources, sourceCount, jobs);
+    } else {
+        BuildJob job = { .sourcePath = sources[0] };
+        if (buildFile(&settings, &job, stdout)) {
+            printf("(successful) Arquivo gerado sem erros de compilação. Arquivo: %s%s%s\n",
+                   settings.emitListing ? job.listingFilename : "",
+                   settings.emitListing && settings.emitBinary ? ", " : "",
+                   settings.emitBinary ? job.binaryFilename : "");
+            status = 0;
+        } else {
+            if (job.message[0])
+                fprintf(job.compileFailed ? stdout : stderr, "%s\n", job.message);
+            status = 1;
+        }
+        if (job.hasStats) {
+            fflush(stdout);
+            printStats(stderr, job.sourcePath, &job.stats, settings.stats);
+        }
     }
 
-    // Initialize structures
-    commandList = NULL;
-    lastCommand = NULL;
-    symbolCount = 0;
-    tempVarCount = 0;
-
-    // Run lexical analysis
-    scanTokens();
-    
-    // Run syntax analysis
-    parseProgram();
-    
-    // Generate assembly code
-    generateAssemblyCode();
-    
-    // Free memory
-    freeCommands(commandList);
-    freeNode(program.output);
-    free(inputCode);
-    fclose(asmOutput);
-    
-    printf("(successful) Arquivo gerado sem erros de compilação. Arquivo: %s\n", outputFilename);
-    return 0;
+    if (showCacheStats && status == 0)
+        neander_cache_print_stats(settings.cacheDir, stdout);
+    for (size_t i = 0; i < sourceCount; i++)
+        free(sources[i]);
+    free(sources);
+    return status;
 }
-
@@ -3,77 +3,966 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
 
-#define MEMORYSIZE 516
+#include "neander.h"
+
+#define MEMORYSIZE NEANDER_RUN_MEMORY
 #define LINESIZE 16
 #define HEADERSIZE 4
+#define CODESLOTS 128   // um slot por pc par (pc é de 8 bits)
+#define CODELIMIT 258   // escritas abaixo disso alteram instruções decodificadas
 
-int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        fprintf(stderr, "Uso: %s <arquivo_bin>\n", argv[0]);
-        return 1;
+#define LOOP_SAMPLE 1024  // passos entre amostras do detector de loop
+
+// Constantes e seções do formato NDR v2 vêm de neander.h
+static const uint8_t ndr_magic[HEADERSIZE] = {0x03, 0x4E, 0x44, 0x52};
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+typedef enum { ENGINE_SWITCH, ENGINE_THREADED, ENGINE_JIT } Engine;
+
+typedef enum { RUN_HALTED, RUN_BUDGET, RUN_LOOP } RunStatus;
+
+// Estado salvo pelo detector de ciclos (algoritmo de Brent)
+typedef struct {
+    uint64_t power, lam;
+    uint64_t hash;
+    bool saved;
+    uint8_t ac, pc;
+    uint8_t bytes[MEMORYSIZE];
+} LoopDetector;
+
+// Estado completo da máquina: a da libneander mais o que os motores daqui usam
+typedef struct {
+    NeanderMachine core;  // ac, pc, flags, passos, RESULT e memória
+    uint64_t budget;      // limite de instruções (0 = sem limite)
+    uint64_t check_at;    // passo em que os motores consultam o watchdog
+    bool detect_loops;
+    bool no_fuse;         // desliga as superinstruções do motor threaded
+    uint64_t fused;       // instruções executadas dentro de superinstruções
+    RunStatus status;
+    LoopDetector loop;
+} Neander;
+
+// Instrução pré-decodificada: handler, operandos resolvidos e sucessores
+typedef struct {
+    const void *handler;
+    uint16_t addr;
+    uint16_t addr2, addr3;  // operandos das instruções seguintes (superinstruções)
+    uint8_t next;    // slot da instrução seguinte
+    uint8_t target;  // slot de desvio (JMP/JMN/JMZ)
+} DecodedOp;
+
+enum {
+    H_NOP, H_STA, H_LDA, H_ADD, H_SUB, H_OR, H_AND, H_NOT, H_JMP, H_JMN, H_JMZ, H_HLT, H_DECODE,
+    // Superinstruções: LDA+ADD+STA, LDA+SUB+STA, LDA+STA, ADD+STA, SUB+STA
+    H_LAS, H_LSS, H_LS, H_AS, H_SS,
+    H_COUNT
+};
+
+static uint64_t state_hash(uint8_t ac, uint8_t pc, const uint8_t *bytes) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ ((uint64_t)ac << 8 | pc);
+    for (int i = 0; i + 8 <= MEMORYSIZE; i += 8) {
+        uint64_t w;
+        memcpy(&w, bytes + i, 8);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 29;
     }
+    uint32_t tail;
+    memcpy(&tail, bytes + MEMORYSIZE - 4, 4);
+    h = (h ^ tail) * 0xC4CEB9FE1A85EC53ULL;
+    return h ^ (h >> 32);
+}
 
-    uint8_t ac = 0, pc = 0;
-    bool z = false, n = false;
+// Calcula o próximo passo em que o watchdog precisa ser consultado
+static void watchdog_arm(Neander *m) {
+    uint64_t at = UINT64_MAX;
+    if (m->budget) at = m->budget;
+    if (m->detect_loops && m->core.steps + LOOP_SAMPLE < at) at = m->core.steps + LOOP_SAMPLE;
+    m->check_at = at;
+}
 
-    FILE *file = fopen(argv[1], "rb");
-    if (!file) {
-        perror("Não foi possível abrir o arquivo binário");
-        return 1;
+/*
+ * Consultado pelos motores quando steps alcança check_at, com ac/pc/steps
+ * já sincronizados em m. Aplica o limite de instruções e amostra o estado
+ * para o detector de ciclos: como a máquina é determinística, repetir o
+ * estado exato (ac, pc e memória) significa que ela nunca vai parar.
+ * Devolve true se a execução deve ser interrompida.
+ */
+static bool watchdog(Neander *m) {
+    if (m->budget && m->core.steps >= m->budget) {
+        m->status = RUN_BUDGET;
+        return true;
+    }
+
+    if (m->detect_loops) {
+        LoopDetector *d = &m->loop;
+        uint64_t h = state_hash(m->core.ac, m->core.pc, m->core.bytes);
+
+        if (d->saved && h == d->hash && m->core.ac == d->ac && m->core.pc == d->pc &&
+            memcmp(m->core.bytes, d->bytes, MEMORYSIZE) == 0) {
+            m->status = RUN_LOOP;
+            return true;
+        }
+        if (!d->saved || d->lam == d->power) {
+            d->hash = h;
+            d->ac = m->core.ac;
+            d->pc = m->core.pc;
+            memcpy(d->bytes, m->core.bytes, MEMORYSIZE);
+            d->power = d->saved ? d->power * 2 : 1;
+            d->saved = true;
+            d->lam = 0;
+        }
+        d->lam++;
     }
 
-    uint8_t bytes[MEMORYSIZE] = {0};
-    uint8_t header[HEADERSIZE];
+    watchdog_arm(m);
+    return false;
+}
 
-    fread(header, 1, HEADERSIZE, file);
-    const uint8_t expected[] = {0x03, 0x4E, 0x44, 0x52};
+static int handler_index(uint8_t opcode) {
+    switch (opcode) {
+        case 0x10: return H_STA;
+        case 0x20: return H_LDA;
+        case 0x30: return H_ADD;
+        case 0x31: return H_SUB;
+        case 0x40: return H_OR;
+        case 0x50: return H_AND;
+        case 0x60: return H_NOT;
+        case 0x80: return H_JMP;
+        case 0x90: return H_JMN;
+        case 0xA0: return H_JMZ;
+        case 0xF0: return H_HLT;
+        default:   return H_NOP;  // opcodes desconhecidos se comportam como NOP
+    }
+}
 
-    if (memcmp(header, expected, HEADERSIZE) != 0) {
-        printf("Cabeçalho inválido!\n");
-        fclose(file);
-        return 1;
+// Decodifica a instrução em pc = 2 * slot, reproduzindo a semântica do switch
+static void decode_plain(const uint8_t *bytes, DecodedOp *op, const void *const *labels, int slot) {
+    uint8_t pc = (uint8_t)(slot * 2);
+    uint16_t addr = bytes[pc + 2] * 2 + HEADERSIZE;
+    int h = handler_index(bytes[pc]);
+
+    op->handler = labels[h];
+    op->addr = addr;
+    op->next = (uint8_t)(pc + (h == H_NOT ? 2 : 4)) >> 1;
+    op->target = (uint8_t)addr >> 1;
+}
+
+/*
+ * Procura em pc uma das sequências que o compilador gera o tempo todo
+ * (LDA X; ADD Y; STA Z e variantes). Devolve o handler fundido e o número
+ * de instruções que ele cobre, ou -1. A sequência não pode atravessar o
+ * fim da área de código, onde o pc de 8 bits dá a volta.
+ */
+static int fuse_index(const uint8_t *bytes, int pc, int *count) {
+    int h[3];
+    int avail = 0;
+    for (int i = 0; i < 3 && pc + 4 * i < 256; i++, avail++)
+        h[i] = handler_index(bytes[pc + 4 * i]);
+
+    if (avail >= 3 && h[0] == H_LDA && h[2] == H_STA && (h[1] == H_ADD || h[1] == H_SUB)) {
+        *count = 3;
+        return h[1] == H_ADD ? H_LAS : H_LSS;
     }
+    if (avail >= 2 && h[1] == H_STA) {
+        *count = 2;
+        if (h[0] == H_LDA) return H_LS;
+        if (h[0] == H_ADD) return H_AS;
+        if (h[0] == H_SUB) return H_SS;
+    }
+    return -1;
+}
 
-    fread(bytes + HEADERSIZE, 1, MEMORYSIZE - HEADERSIZE, file);
-    fclose(file);
+/*
+ * Decodifica o slot. Com fusão ligada, o slot pode virar uma superinstrução;
+ * plain guarda a versão simples, usada quando o watchdog precisa parar no
+ * meio da sequência. Desvios para o meio caem em slots próprios, decodificados
+ * normalmente.
+ */
+static void decode_slot(const Neander *m, DecodedOp *ops, DecodedOp *plain,
+                        const void *const *labels, int slot) {
+    decode_plain(m->core.bytes, &ops[slot], labels, slot);
+    if (m->no_fuse)
+        return;
+
+    int pc = slot * 2, count;
+    int h = fuse_index(m->core.bytes, pc, &count);
+    if (h < 0)
+        return;
+
+    plain[slot] = ops[slot];
+    ops[slot].handler = labels[h];
+    ops[slot].addr2 = m->core.bytes[pc + 6] * 2 + HEADERSIZE;
+    if (count == 3)
+        ops[slot].addr3 = m->core.bytes[pc + 10] * 2 + HEADERSIZE;
+    ops[slot].next = (uint8_t)(pc + 4 * count) >> 1;
+}
+
+// Uma escrita em addr invalida todo slot cuja decodificação leu esse byte
+static void invalidate_slots(DecodedOp *ops, uint16_t addr, const void *decode) {
+    int last = addr >> 1, first = last - 5;  // superinstruções leem até 12 bytes
+    if (last >= CODESLOTS) last = CODESLOTS - 1;
+    if (first < 0) first = 0;
+    for (int slot = first; slot <= last; slot++)
+        ops[slot].handler = decode;
+}
+
+// Interpretador switch da libneander, parando em check_at para o watchdog
+static void run_switch(Neander *m) {
+    while (!neander_step(&m->core, m->check_at) && !watchdog(m))
+        ;
+}
+
+/*
+ * Loop com despacho por computed goto sobre a imagem pré-decodificada.
+ * As flags z/n só são derivadas do acumulador quando JMN/JMZ as leem.
+ * Superinstruções contam todos os passos que cobrem; se o watchdog cair
+ * no meio de uma, executa-se só a primeira instrução, pela versão simples,
+ * e o limite continua exato.
+ */
+static void run_threaded(Neander *m) {
+    static const void *const labels[H_COUNT] = {
+        [H_NOP] = &&op_nop, [H_STA] = &&op_sta, [H_LDA] = &&op_lda,
+        [H_ADD] = &&op_add, [H_SUB] = &&op_sub, [H_OR]  = &&op_or,
+        [H_AND] = &&op_and, [H_NOT] = &&op_not, [H_JMP] = &&op_jmp,
+        [H_JMN] = &&op_jmn, [H_JMZ] = &&op_jmz, [H_HLT] = &&op_hlt,
+        [H_DECODE] = &&op_decode,
+        [H_LAS] = &&op_las, [H_LSS] = &&op_lss, [H_LS] = &&op_ls,
+        [H_AS]  = &&op_as,  [H_SS]  = &&op_ss,
+    };
+
+    // Slots são decodificados na primeira visita
+    DecodedOp ops[CODESLOTS], plain[CODESLOTS];
+    for (int slot = 0; slot < CODESLOTS; slot++)
+        ops[slot].handler = &&op_decode;
+
+    uint8_t ac = m->core.ac;
+    uint8_t *bytes = m->core.bytes;
+    uint64_t steps = m->core.steps, check_at = m->check_at;
+    uint64_t fused = m->fused;
+    const DecodedOp *op = &ops[m->core.pc >> 1];
+
+#define DISPATCH() do { if (__builtin_expect(steps >= check_at, 0)) goto check; goto *op->handler; } while (0)
+#define NEXT()     do { op = &ops[op->next]; steps++; DISPATCH(); } while (0)
+#define BRANCH(c)  do { op = &ops[(c) ? op->target : op->next]; steps++; DISPATCH(); } while (0)
+// Grava o acumulador e segue; escrever na área de código invalida os slots afetados
+#define STORE(a, k) do {                                                    \
+        uint16_t dst = (a);                                                 \
+        bytes[dst] = ac;                                                    \
+        op = &ops[op->next];                                                \
+        steps += (k);                                                       \
+        if (__builtin_expect(dst < CODELIMIT, 0))                           \
+            invalidate_slots(ops, dst, &&op_decode);                        \
+        DISPATCH();                                                         \
+    } while (0)
+#define FUSED(k) do {                                                       \
+        if (__builtin_expect(steps + (k) > check_at, 0)) {                  \
+            op = &plain[op - ops];                                          \
+            goto *op->handler;                                              \
+        }                                                                   \
+        fused += (k);                                                       \
+    } while (0)
+
+    DISPATCH();
+
+op_nop: NEXT();
+op_sta: STORE(op->addr, 1);
+op_lda: ac = bytes[op->addr]; NEXT();
+op_add: ac += bytes[op->addr]; NEXT();
+op_sub: ac -= bytes[op->addr]; NEXT();
+op_or:  ac |= bytes[op->addr]; NEXT();
+op_and: ac &= bytes[op->addr]; NEXT();
+op_not: ac = ~ac; NEXT();
+op_jmp: BRANCH(true);
+op_jmn: BRANCH(ac & 0x80);
+op_jmz: BRANCH(ac == 0);
+op_las: FUSED(3); ac = bytes[op->addr] + bytes[op->addr2]; STORE(op->addr3, 3);
+op_lss: FUSED(3); ac = bytes[op->addr] - bytes[op->addr2]; STORE(op->addr3, 3);
+op_ls:  FUSED(2); ac = bytes[op->addr]; STORE(op->addr2, 2);
+op_as:  FUSED(2); ac += bytes[op->addr]; STORE(op->addr2, 2);
+op_ss:  FUSED(2); ac -= bytes[op->addr]; STORE(op->addr2, 2);
+op_decode:
+    decode_slot(m, ops, plain, labels, (int)(op - ops));
+    DISPATCH();
+check:
+    m->core.ac = ac;
+    m->core.pc = (uint8_t)((op - ops) * 2);
+    m->core.steps = steps;
+    if (bytes[m->core.pc] == 0xF0) goto op_hlt;
+    if (!watchdog(m)) {
+        check_at = m->check_at;
+        goto *op->handler;
+    }
+op_hlt:
+    m->core.ac = ac;
+    m->core.pc = (uint8_t)((op - ops) * 2);
+    m->core.z = (ac == 0);
+    m->core.n = (ac & 0x80) != 0;
+    m->core.steps = steps;
+    m->fused = fused;
+
+#undef DISPATCH
+#undef NEXT
+#undef BRANCH
+#undef STORE
+#undef FUSED
+}
+
+#if defined(__x86_64__) && defined(__linux__)
+#define HAVE_JIT 1
+#else
+#define HAVE_JIT 0
+typedef struct { uint8_t *buf; } Jit;
+static bool jit_init(Jit *j) { j->buf = NULL; return false; }
+static void jit_release(Jit *j) { (void)j; }
+#endif
+
+#if HAVE_JIT
+/*
+ * JIT x86-64 por bloco básico. Cada bloco (código entre alvos de
+ * JMP/JMN/JMZ) vira código nativo com o acumulador em AL e a memória
+ * endereçada diretamente a partir de RDI. Blocos encadeiam-se por saltos
+ * diretos; só se volta ao C em HLT, quando um bloco não pode ser
+ * traduzido (STA sobre a área de código), que roda no interpretador, ou
+ * quando o combustível (passos até o próximo watchdog) acaba.
+ */
+#define JIT_BUFSIZE 16384
+
+enum { JIT_HALT, JIT_INTERP, JIT_FUEL };
+enum { SLOT_NONE, SLOT_NATIVE, SLOT_STUB };
+
+typedef struct {
+    uint8_t ac;
+    uint8_t pc;
+    uint8_t reason;
+    uint8_t pad[5];
+    uint64_t fuel;   // instruções que ainda podem rodar antes de voltar ao C
+} JitState;
+
+typedef void (*JitEntry)(uint8_t *mem, JitState *st, const void *target);
+
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t block[CODESLOTS];   // deslocamento de cada bloco no buffer
+    uint8_t kind[CODESLOTS];
+    struct { size_t at; uint8_t slot; } fixups[CODESLOTS * 3];
+    int fixup_count;
+    uint16_t code_limit;       // escritas abaixo disso alteram código alcançável
+} Jit;
+
+static void jit_byte(Jit *j, uint8_t b) { j->buf[j->len++] = b; }
+
+static void jit_u32(Jit *j, uint32_t v) {
+    memcpy(j->buf + j->len, &v, 4);
+    j->len += 4;
+}
+
+// Salto rel32 para o bloco do slot indicado (resolvido depois)
+static void jit_rel32(Jit *j, uint8_t slot) {
+    j->fixups[j->fixup_count].at = j->len;
+    j->fixups[j->fixup_count].slot = slot;
+    j->fixup_count++;
+    jit_u32(j, 0);
+}
+
+// op al, [rdi + addr]
+static void jit_mem_op(Jit *j, uint8_t opcode, uint16_t addr) {
+    jit_byte(j, opcode);
+    jit_byte(j, 0x87);
+    jit_u32(j, addr);
+}
+
+// Salva AL e pc em JitState e retorna ao C
+static void jit_exit(Jit *j, uint8_t pc, uint8_t reason) {
+    jit_byte(j, 0x88); jit_byte(j, 0x06);                          // mov [rsi], al
+    jit_byte(j, 0xC6); jit_byte(j, 0x46); jit_byte(j, 0x01); jit_byte(j, pc);      // mov byte [rsi+1], pc
+    jit_byte(j, 0xC6); jit_byte(j, 0x46); jit_byte(j, 0x02); jit_byte(j, reason);  // mov byte [rsi+2], reason
+    jit_byte(j, 0xC3);                                              // ret
+}
+
+static uint8_t jit_next_pc(uint8_t pc, uint8_t opcode) {
+    return (uint8_t)(pc + (opcode == 0x60 ? 2 : 4));
+}
+
+static bool jit_is_branch(uint8_t opcode) {
+    return opcode == 0x80 || opcode == 0x90 || opcode == 0xA0;
+}
+
+// Marca líderes de bloco alcançáveis a partir de entry
+// Marca os inícios de bloco e, em seen, os slots alcançáveis a partir de entry
+static void jit_find_leaders(const Neander *m, uint8_t entry, bool *leader, bool *seen) {
+    uint8_t work[CODESLOTS * 2];
+    int top = 0;
+
+    leader[entry >> 1] = true;
+    work[top++] = entry;
+    while (top > 0) {
+        uint8_t pc = work[--top];
+        while (!seen[pc >> 1]) {
+            seen[pc >> 1] = true;
+            uint8_t opcode = m->core.bytes[pc];
+            uint8_t target = (uint8_t)(m->core.bytes[pc + 2] * 2 + HEADERSIZE);
+            uint8_t next = jit_next_pc(pc, opcode);
 
+            if (opcode == 0xF0) break;
+            if (jit_is_branch(opcode)) {
+                leader[target >> 1] = true;
+                work[top++] = target;
+                if (opcode == 0x80) break;
+                leader[next >> 1] = true;
+            }
+            if (next <= pc) leader[next >> 1] = true;  // volta ao início da memória
+            pc = next;
+        }
+    }
+}
+
+static bool jit_block_translatable(const Jit *j, const Neander *m, uint8_t pc, const bool *leader) {
+    for (;;) {
+        uint8_t opcode = m->core.bytes[pc];
+        uint16_t addr = m->core.bytes[pc + 2] * 2 + HEADERSIZE;
+        uint8_t next = jit_next_pc(pc, opcode);
+
+        if (opcode == 0x10 && addr < j->code_limit) return false;
+        if (opcode == 0xF0 || jit_is_branch(opcode) || leader[next >> 1]) return true;
+        pc = next;
+    }
+}
+
+static void jit_emit_block(Jit *j, const Neander *m, uint8_t pc, const bool *leader) {
+    size_t sub_at, add_at;
+    uint8_t leader_pc = pc;
+
+    // Consome n de combustível; se não houver, devolve e sai antes do bloco
+    jit_byte(j, 0x48); jit_byte(j, 0x81); jit_byte(j, 0x6E); jit_byte(j, 0x08);  // sub qword [rsi+8], n
+    sub_at = j->len;
+    jit_u32(j, 0);
+    jit_byte(j, 0x73); jit_byte(j, 0);                                          // jae corpo
+    size_t skip_at = j->len;
+    jit_byte(j, 0x48); jit_byte(j, 0x81); jit_byte(j, 0x46); jit_byte(j, 0x08);  // add qword [rsi+8], n
+    add_at = j->len;
+    jit_u32(j, 0);
+    jit_exit(j, leader_pc, JIT_FUEL);
+    j->buf[skip_at - 1] = (uint8_t)(j->len - skip_at);
+
+    uint32_t count = 0;
+    for (;;) {
+        uint8_t opcode = m->core.bytes[pc];
+        uint16_t addr = m->core.bytes[pc + 2] * 2 + HEADERSIZE;
+        uint8_t next = jit_next_pc(pc, opcode);
+
+        if (opcode == 0xF0) {
+            jit_exit(j, pc, JIT_HALT);
+            break;
+        }
+
+        count++;
+        switch (opcode) {
+            case 0x10: jit_mem_op(j, 0x88, addr); break;  // STA: mov [rdi+a], al
+            case 0x20: jit_mem_op(j, 0x8A, addr); break;  // LDA: mov al, [rdi+a]
+            case 0x30: jit_mem_op(j, 0x02, addr); break;  // ADD: add al, [rdi+a]
+            case 0x31: jit_mem_op(j, 0x2A, addr); break;  // SUB: sub al, [rdi+a]
+            case 0x40: jit_mem_op(j, 0x0A, addr); break;  // OR:  or al, [rdi+a]
+            case 0x50: jit_mem_op(j, 0x22, addr); break;  // AND: and al, [rdi+a]
+            case 0x60: jit_byte(j, 0xF6); jit_byte(j, 0xD0); break;  // NOT: not al
+            case 0x80:                                                // JMP
+                jit_byte(j, 0xE9);
+                jit_rel32(j, (uint8_t)addr >> 1);
+                break;
+            case 0x90:                                                // JMN: test al, al; js
+            case 0xA0:                                                // JMZ: test al, al; jz
+                jit_byte(j, 0x84); jit_byte(j, 0xC0);
+                jit_byte(j, 0x0F); jit_byte(j, opcode == 0x90 ? 0x88 : 0x84);
+                jit_rel32(j, (uint8_t)addr >> 1);
+                jit_byte(j, 0xE9);
+                jit_rel32(j, next >> 1);
+                break;
+            default: break;                                           // NOP
+        }
+
+        if (jit_is_branch(opcode)) break;
+        if (leader[next >> 1]) {
+            jit_byte(j, 0xE9);
+            jit_rel32(j, next >> 1);
+            break;
+        }
+        pc = next;
+    }
+
+    memcpy(j->buf + sub_at, &count, 4);
+    memcpy(j->buf + add_at, &count, 4);
+}
+
+static bool jit_compile(Jit *j, const Neander *m) {
+    bool leader[CODESLOTS] = {false}, seen[CODESLOTS] = {false};
+    jit_find_leaders(m, m->core.pc, leader, seen);
+    // O byte 256 é o operando do slot 254, mas também a primeira palavra de
+    // dados (RESULT, no compilador): só conta como código se o slot é alcançável
+    j->code_limit = seen[CODESLOTS - 1] ? CODELIMIT : VAR_START;
+
+    if (mprotect(j->buf, JIT_BUFSIZE, PROT_READ | PROT_WRITE) != 0)
+        return false;
+    j->len = 0;
+    j->fixup_count = 0;
+    memset(j->kind, SLOT_NONE, sizeof(j->kind));
+
+    // Prólogo: carrega o acumulador e salta para o bloco pedido
+    jit_byte(j, 0x0F); jit_byte(j, 0xB6); jit_byte(j, 0x06);  // movzx eax, byte [rsi]
+    jit_byte(j, 0xFF); jit_byte(j, 0xE2);                     // jmp rdx
+
+    for (int slot = 0; slot < CODESLOTS; slot++) {
+        if (!leader[slot]) continue;
+        uint8_t pc = (uint8_t)(slot * 2);
+        j->block[slot] = j->len;
+        if (jit_block_translatable(j, m, pc, leader)) {
+            j->kind[slot] = SLOT_NATIVE;
+            jit_emit_block(j, m, pc, leader);
+        } else {
+            j->kind[slot] = SLOT_STUB;
+            jit_exit(j, pc, JIT_INTERP);
+        }
+    }
+
+    for (int i = 0; i < j->fixup_count; i++) {
+        int32_t rel = (int32_t)(j->block[j->fixups[i].slot] - (j->fixups[i].at + 4));
+        memcpy(j->buf + j->fixups[i].at, &rel, 4);
+    }
+
+    return mprotect(j->buf, JIT_BUFSIZE, PROT_READ | PROT_EXEC) == 0;
+}
+
+// Executa uma instrução no interpretador; devolve true se escreveu na área de código
+static bool jit_interp_step(Neander *m, uint16_t code_limit) {
+    uint8_t pc = m->core.pc, ac = m->core.ac;
+    uint8_t opcode = m->core.bytes[pc];
+    uint16_t addr = m->core.bytes[pc + 2] * 2 + HEADERSIZE;
+    bool wrote_code = false;
+
+    m->core.steps++;
+    switch (opcode) {
+        case 0x10: m->core.bytes[addr] = ac; wrote_code = addr < code_limit; break;
+        case 0x20: ac = m->core.bytes[addr]; break;
+        case 0x30: ac += m->core.bytes[addr]; break;
+        case 0x31: ac -= m->core.bytes[addr]; break;
+        case 0x40: ac |= m->core.bytes[addr]; break;
+        case 0x50: ac &= m->core.bytes[addr]; break;
+        case 0x60: ac = ~ac; break;
+        case 0x80: m->core.pc = (uint8_t)addr; m->core.ac = ac; return false;
+        case 0x90: if (ac & 0x80) { m->core.pc = (uint8_t)addr; return false; } break;
+        case 0xA0: if (ac == 0) { m->core.pc = (uint8_t)addr; return false; } break;
+        default: break;
+    }
+    m->core.ac = ac;
+    m->core.pc = jit_next_pc(pc, opcode);
+    return wrote_code;
+}
+
+static bool jit_init(Jit *j) {
+    j->buf = mmap(NULL, JIT_BUFSIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return j->buf != MAP_FAILED;
+}
+
+static void jit_release(Jit *j) {
+    if (j->buf && j->buf != MAP_FAILED) munmap(j->buf, JIT_BUFSIZE);
+    j->buf = NULL;
+}
+
+// j deve ter sido preparado com jit_init; o buffer é reaproveitado entre execuções
+static void run_jit(Neander *m, Jit *j) {
+    if (!j->buf || j->buf == MAP_FAILED || !jit_compile(j, m)) {
+        run_threaded(m);
+        return;
+    }
+
+    JitEntry entry = (JitEntry)(void *)j->buf;
+    JitState st = {0};
+    bool out_of_fuel = false;
+
+    while (m->core.bytes[m->core.pc] != 0xF0) {
+        if (m->core.steps >= m->check_at) {
+            if (watchdog(m)) break;
+            out_of_fuel = false;
+        }
+
+        if (j->kind[m->core.pc >> 1] == SLOT_NATIVE && !out_of_fuel) {
+            st.ac = m->core.ac;
+            st.fuel = m->check_at - m->core.steps;
+            uint64_t fuel = st.fuel;
+            entry(m->core.bytes, &st, j->buf + j->block[m->core.pc >> 1]);
+            m->core.ac = st.ac;
+            m->core.pc = st.pc;
+            m->core.steps += fuel - st.fuel;
+            if (st.reason == JIT_HALT) break;
+            // Bloco maior que o combustível: avança passo a passo até o watchdog
+            out_of_fuel = st.reason == JIT_FUEL;
+            continue;
+        }
+
+        if (jit_interp_step(m, j->code_limit)) {
+            // Código alterado: blocos compilados podem estar obsoletos
+            run_threaded(m);
+            return;
+        }
+    }
+
+    m->core.z = (m->core.ac == 0);
+    m->core.n = (m->core.ac & 0x80) != 0;
+}
+#endif
+
+/*
+ * Perfil de execução: contagens por opcode, por pc e leituras/escritas
+ * por palavra de dados. Roda sobre um interpretador instrumentado com a
+ * mesma semântica do motor switch.
+ */
+#define WORDS (MEMORYSIZE / 2)
+#define HOTSPOTS 10
+
+typedef struct {
+    uint64_t by_opcode[256];
+    uint64_t by_pc[256];
+    uint64_t reads[WORDS];
+    uint64_t writes[WORDS];
+} Profile;
+
+// Linha do .asm de cada instrução e nome de cada palavra de dados
+typedef struct {
+    int line[CODESLOTS];
+    char *text[CODESLOTS];
+    char *name[WORDS];
+} AsmMap;
+
+static const char *opcode_name(uint8_t opcode) {
+    switch (opcode) {
+        case 0x00: return "NOP";
+        case 0x10: return "STA";
+        case 0x20: return "LDA";
+        case 0x30: return "ADD";
+        case 0x31: return "SUB";
+        case 0x40: return "OR";
+        case 0x50: return "AND";
+        case 0x60: return "NOT";
+        case 0x80: return "JMP";
+        case 0x90: return "JMN";
+        case 0xA0: return "JMZ";
+        case 0xF0: return "HLT";
+        default:   return "???";
+    }
+}
+
+static int opcode_from_name(const char *mnemonic) {
+    static const uint8_t known[] = {0x00, 0x10, 0x20, 0x30, 0x31, 0x40, 0x50, 0x60, 0x80, 0x90, 0xA0, 0xF0};
+    for (size_t i = 0; i < sizeof(known); i++)
+        if (strcasecmp(mnemonic, opcode_name(known[i])) == 0) return known[i];
+    return -1;
+}
+
+static bool opcode_reads_memory(uint8_t opcode) {
+    return opcode == 0x20 || opcode == 0x30 || opcode == 0x31 || opcode == 0x40 || opcode == 0x50;
+}
+
+static void run_profiled(Neander *m, Profile *p) {
+    uint8_t ac = m->core.ac, pc = m->core.pc;
+    uint8_t *bytes = m->core.bytes;
+
+    watchdog_arm(m);
     while (bytes[pc] != 0xF0) {
-        z = (ac == 0);
-        n = (ac & 0x80) != 0;
+        if (m->core.steps >= m->check_at) {
+            m->core.ac = ac;
+            m->core.pc = pc;
+            if (watchdog(m)) break;
+        }
+
+        uint8_t opcode = bytes[pc];
         uint16_t addr = bytes[pc + 2] * 2 + HEADERSIZE;
 
-        switch (bytes[pc]) {
-            case 0x00: break;                       // NOP
-            case 0x10: bytes[addr] = ac; break;     // STA
-            case 0x20: ac = bytes[addr]; break;     // LDA
-            case 0x30: ac += bytes[addr]; break;    // ADD
-            case 0x31: ac -= bytes[addr]; break;    // SUB
-            case 0x40: ac |= bytes[addr]; break;    // OR
-            case 0x50: ac &= bytes[addr]; break;    // AND
-            case 0x60: ac = ~ac; pc += 2; continue; // NOT
-            case 0x80: pc = addr; continue;         // JMP
-            case 0x90: if (n) { pc = addr; continue; } break; // JMN
-            case 0xA0: if (z) { pc = addr; continue; } break; // JMZ
-            case 0xF0: break; // HLT
+        p->by_opcode[opcode]++;
+        p->by_pc[pc]++;
+        if (opcode_reads_memory(opcode)) p->reads[addr >> 1]++;
+        if (opcode == 0x10) p->writes[addr >> 1]++;
+        m->core.steps++;
+
+        switch (opcode) {
+            case 0x10: bytes[addr] = ac; break;
+            case 0x20: ac = bytes[addr]; break;
+            case 0x30: ac += bytes[addr]; break;
+            case 0x31: ac -= bytes[addr]; break;
+            case 0x40: ac |= bytes[addr]; break;
+            case 0x50: ac &= bytes[addr]; break;
+            case 0x60: ac = ~ac; pc += 2; continue;
+            case 0x80: pc = addr; continue;
+            case 0x90: if (ac & 0x80) { pc = addr; continue; } break;
+            case 0xA0: if (ac == 0) { pc = addr; continue; } break;
         }
 
         pc += 4;
     }
 
-    // Localiza resultado na memória
-    int found = 0;
-    int resultAddress = -1;
-    for (int i = HEADERSIZE; i < MEMORYSIZE; i += 2) {
-        if (bytes[i] == ac) {
-            resultAddress = i;
-            found = 1;
-            break;
+    m->core.ac = ac;
+    m->core.pc = pc;
+    m->core.z = (ac == 0);
+    m->core.n = (ac & 0x80) != 0;
+}
+
+static char *dup_trimmed(const char *s) {
+    while (*s == ' ' || *s == '\t') s++;
+    size_t len = strcspn(s, "\r\n");
+    char *copy = malloc(len + 1);
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+static bool load_asm_map(const char *path, AsmMap *map) {
+    FILE *src = fopen(path, "r");
+    if (!src) return false;
+
+    // Linhas de qualquer tamanho, como no assembler: um comentário longo
+    // não pode virar duas linhas e deslocar a numeração
+    char *line = NULL, *copy = NULL;
+    size_t line_cap = 0, copy_cap = 0;
+    ssize_t len;
+    int lineno = 0, pc = HEADERSIZE;
+    bool in_code = false;
+
+    while ((len = getline(&line, &line_cap, src)) >= 0) {
+        lineno++;
+        if ((size_t)len >= copy_cap) {
+            copy_cap = (size_t)len + 1;
+            copy = realloc(copy, copy_cap);
+        }
+        memcpy(copy, line, (size_t)len + 1);
+        char *token = strtok(copy, " \t\r\n");
+        if (!token || token[0] == ';') continue;
+
+        if (strcasecmp(token, ".DATA") == 0) {
+            in_code = false;
+        } else if (strcasecmp(token, ".CODE") == 0) {
+            in_code = true;
+        } else if (strcasecmp(token, ".ORG") == 0) {
+            char *val = strtok(NULL, " \t\r\n");
+            pc = val ? atoi(val) * 2 + HEADERSIZE : HEADERSIZE;
+        } else if (in_code) {
+            // Rótulos não ocupam espaço; a instrução pode vir na mesma linha
+            char *colon = strchr(token, ':');
+            if (colon) {
+                token = colon[1] ? colon + 1 : strtok(NULL, " \t\r\n");
+                if (!token || token[0] == ';') continue;
+            }
+
+            int opcode = opcode_from_name(token);
+            if (opcode < 0 || pc < 0 || pc >= 256) continue;
+
+            map->line[pc >> 1] = lineno;
+            map->text[pc >> 1] = dup_trimmed(line);
+            pc += 4;
+        }
+    }
+
+    free(line);
+    free(copy);
+    fclose(src);
+    return true;
+}
+
+// Nomes exatos das palavras de dados, da seção de símbolos de uma imagem v2
+static void load_symbol_names(const char *path, AsmMap *map) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return;
+
+    uint8_t header[NDR_V2_HEADER];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        memcmp(header, ndr_magic, HEADERSIZE) != 0 || header[4] != NDR_V2_MARKER) {
+        fclose(file);
+        return;
+    }
+
+    uint16_t sections = get_u16(header + 12);
+    for (int i = 0; i < sections; i++) {
+        uint8_t sec[NDR_SECTION_LEN];
+        fseek(file, NDR_V2_HEADER + i * NDR_SECTION_LEN, SEEK_SET);
+        if (fread(sec, 1, sizeof(sec), file) != sizeof(sec)) break;
+        if (sec[0] != SECTION_SYMBOLS) continue;
+
+        uint16_t size = get_u16(sec + 4);
+        uint8_t *data = malloc(size);
+        fseek(file, get_u16(sec + 6), SEEK_SET);
+        if (fread(data, 1, size, file) == size) {
+            for (int at = 0; at + 4 <= size && at + 4 + data[at + 3] <= size; at += 4 + data[at + 3]) {
+                int w = get_u16(data + at) >> 1;
+                if (w >= WORDS || data[at + 2] != SYM_DATA) continue;  // rótulos ficam de fora
+                free(map->name[w]);
+                map->name[w] = strndup((const char *)data + at + 4, data[at + 3]);
+            }
+        }
+        free(data);
+    }
+    fclose(file);
+}
+
+static void free_asm_map(AsmMap *map) {
+    for (int i = 0; i < CODESLOTS; i++) free(map->text[i]);
+    for (int i = 0; i < WORDS; i++) free(map->name[i]);
+}
+
+// Conteúdo de uma string JSON: aspas, barra e caracteres de controle
+// escapados; trunca em cap sem cortar um escape ao meio
+static size_t json_escape(char *out, size_t cap, const char *s) {
+    size_t len = 0;
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        char esc[8];
+        int n;
+        switch (c) {
+            case '"':  n = snprintf(esc, sizeof(esc), "\\\""); break;
+            case '\\': n = snprintf(esc, sizeof(esc), "\\\\"); break;
+            case '\n': n = snprintf(esc, sizeof(esc), "\\n"); break;
+            case '\r': n = snprintf(esc, sizeof(esc), "\\r"); break;
+            case '\t': n = snprintf(esc, sizeof(esc), "\\t"); break;
+            default:
+                if (c < 0x20) n = snprintf(esc, sizeof(esc), "\\u%04x", c);
+                else { esc[0] = (char)c; n = 1; }
+        }
+        if (len + n >= cap) break;
+        memcpy(out + len, esc, n);
+        len += n;
+    }
+    out[len] = '\0';
+    return len;
+}
+
+static void write_profile_json(FILE *out, const char *program, const Neander *m, const Profile *p, const AsmMap *map) {
+    char escaped[PATH_MAX * 6];
+    json_escape(escaped, sizeof(escaped), program);
+    fprintf(out, "{\n  \"program\": \"%s\",\n  \"instructions\": %llu,\n", escaped, (unsigned long long)m->core.steps);
+
+    fprintf(out, "  \"opcodes\": {");
+    bool first = true;
+    for (int op = 0; op < 256; op++) {
+        if (!p->by_opcode[op]) continue;
+        fprintf(out, "%s\n    \"%s\": %llu", first ? "" : ",",
+                strcmp(opcode_name((uint8_t)op), "???") ? opcode_name((uint8_t)op) : "UNKNOWN",
+                (unsigned long long)p->by_opcode[op]);
+        first = false;
+    }
+    fprintf(out, "\n  },\n  \"pcs\": [");
+
+    first = true;
+    for (int pc = 0; pc < 256; pc++) {
+        if (!p->by_pc[pc]) continue;
+        fprintf(out, "%s\n    {\"pc\": %d, \"count\": %llu, \"op\": \"%s\", \"operand\": %d",
+                first ? "" : ",", pc, (unsigned long long)p->by_pc[pc],
+                opcode_name(m->core.bytes[pc]), m->core.bytes[pc + 2]);
+        if (map->line[pc >> 1])
+            fprintf(out, ", \"asm_line\": %d", map->line[pc >> 1]);
+        fprintf(out, "}");
+        first = false;
+    }
+    fprintf(out, "\n  ],\n  \"memory\": [");
+
+    first = true;
+    for (int w = 0; w < WORDS; w++) {
+        if (!p->reads[w] && !p->writes[w]) continue;
+        fprintf(out, "%s\n    {\"address\": %d, \"word\": %d", first ? "" : ",", w * 2, (w * 2 - HEADERSIZE) / 2);
+        if (map->name[w]) {
+            json_escape(escaped, sizeof(escaped), map->name[w]);
+            fprintf(out, ", \"name\": \"%s\"", escaped);
         }
+        fprintf(out, ", \"reads\": %llu, \"writes\": %llu}",
+                (unsigned long long)p->reads[w], (unsigned long long)p->writes[w]);
+        first = false;
     }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+static void print_hotspots(const Neander *m, const Profile *p, const AsmMap *map) {
+    bool taken[256] = {false};
 
-    if (found) {
-        uint8_t raw = bytes[resultAddress];
+    printf("Pontos quentes (top %d):\n", HOTSPOTS);
+    printf("  %-6s %12s %7s  %-10s %s\n", "pc", "execuções", "%", "instrução", "linha .asm");
+    for (int k = 0; k < HOTSPOTS; k++) {
+        int best = -1;
+        for (int pc = 0; pc < 256; pc++)
+            if (!taken[pc] && p->by_pc[pc] && (best < 0 || p->by_pc[pc] > p->by_pc[best]))
+                best = pc;
+        if (best < 0) break;
+        taken[best] = true;
+
+        double pct = m->core.steps ? 100.0 * p->by_pc[best] / m->core.steps : 0.0;
+        printf("  0x%02X   %12llu %6.1f%%  %-4s 0x%02X  ", best, (unsigned long long)p->by_pc[best], pct,
+               opcode_name(m->core.bytes[best]), m->core.bytes[best + 2]);
+        if (map->line[best >> 1])
+            printf("%d: %s\n", map->line[best >> 1], map->text[best >> 1]);
+        else
+            printf("-\n");
+    }
+}
+
+/*
+ * Carrega uma imagem v1 (memória crua após o magic) ou v2 (cabeçalho
+ * versionado com tabela de seções). Lê de uma vez até MEMORYSIZE bytes
+ * em buf; no v2 só as seções de código e dados são copiadas para a
+ * memória, buscando com pread o que estiver além do trecho já lido.
+ */
+static bool fetch_section(void *source, uint8_t *dest, size_t size, size_t offset) {
+    return pread(*(int *)source, dest, size, (off_t)offset) == (ssize_t)size;
+}
+
+static NeanderLoadStatus load_fd(int fd, Neander *m, uint8_t *buf) {
+    ssize_t len = 0, got = 0;
+    while (len < MEMORYSIZE && (got = read(fd, buf + len, MEMORYSIZE - len)) > 0)
+        len += got;
+    if (got < 0) return NEANDER_LOAD_IO;
+
+    memset(m, 0, sizeof(*m));
+    return neander_load(&m->core, buf, (size_t)len, fetch_section, &fd);
+}
+
+static bool load_program(const char *path, Neander *m) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Não foi possível abrir o arquivo binário");
+        return false;
+    }
+
+    uint8_t buf[MEMORYSIZE];
+    NeanderLoadStatus status = load_fd(fd, m, buf);
+    close(fd);
+
+    if (status == NEANDER_LOAD_IO) {
+        perror("Erro ao ler o arquivo binário");
+        return false;
+    }
+    if (status == NEANDER_LOAD_HEADER) {
+        printf("Cabeçalho inválido!\n");
+        return false;
+    }
+    return true;
+}
+
+static void print_result(const Neander *m) {
+    uint8_t raw;
+
+    if (m->status == RUN_LOOP) {
+        printf("Loop infinito em pc 0x%02X (estado repetido após %llu instruções)\n",
+               m->core.pc, (unsigned long long)m->core.steps);
+    } else if (m->status == RUN_BUDGET) {
+        printf("Limite de %llu instruções atingido em pc 0x%02X\n",
+               (unsigned long long)m->budget, m->core.pc);
+    } else if (neander_result(&m->core, &raw)) {
         int8_t signed_val = (int8_t)raw;
 
         printf("Conta final (hexa) = 0x%02X\n", raw);
@@ -81,7 +970,412 @@ int main(int argc, char *argv[]) {
     } else {
         printf("Conta final (hexa) = ERRO\n");
     }
+}
+
+static void run_engine(Engine engine, Neander *m, Jit *jit) {
+    watchdog_arm(m);
+    if (engine == ENGINE_SWITCH)
+        run_switch(m);
+#if HAVE_JIT
+    else if (engine == ENGINE_JIT)
+        run_jit(m, jit);
+#endif
+    else
+        run_threaded(m);
+    (void)jit;
+}
+
+// Troca a extensão de path (ou acrescenta, se não houver)
+static char *replace_extension(const char *path, const char *ext) {
+    const char *dot = strrchr(path, '.');
+    const char *slash = strrchr(path, '/');
+    size_t base = (dot && (!slash || dot > slash)) ? (size_t)(dot - path) : strlen(path);
+    char *out = malloc(base + strlen(ext) + 1);
+    memcpy(out, path, base);
+    strcpy(out + base, ext);
+    return out;
+}
+
+static int run_profile_mode(const char *path, const Neander *image, const char *profile_path, const char *asm_path) {
+    static Neander m;
+    static Profile p;
+    static AsmMap map;
+
+    m = *image;
+    run_profiled(&m, &p);
+    print_result(&m);
+    int status = m.status == RUN_HALTED ? 0 : 2;
+
+    char *default_asm = replace_extension(path, ".asm");
+    if (!load_asm_map(asm_path ? asm_path : default_asm, &map) && asm_path)
+        fprintf(stderr, "Aviso: não foi possível abrir %s; relatório sem linhas do .asm\n", asm_path);
+    free(default_asm);
+    load_symbol_names(path, &map);
+
+    print_hotspots(&m, &p, &map);
+
+    char *default_json = replace_extension(path, ".profile.json");
+    const char *json_path = profile_path ? profile_path : default_json;
+    FILE *out = fopen(json_path, "w");
+    if (out) {
+        write_profile_json(out, path, &m, &p, &map);
+        fclose(out);
+        printf("Perfil gravado em %s\n", json_path);
+    } else {
+        perror("Erro ao criar relatório de perfil");
+        status = 1;
+    }
+
+    free(default_json);
+    free_asm_map(&map);
+    return status;
+}
+
+static double elapsed_us(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e6 + (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+/*
+ * Modo lote: executa muitas imagens em um pool de threads. Cada worker
+ * tem um contexto pré-alocado (máquina, buffer de leitura e JIT) que é
+ * reaproveitado para todos os programas que processa; os resultados saem
+ * em CSV ou JSONL, uma linha por programa, à medida que terminam.
+ */
+typedef enum { FORMAT_CSV, FORMAT_JSONL } OutputFormat;
+
+typedef struct {
+    char **paths;
+    size_t count;
+    size_t next;
+    Engine engine;
+    OutputFormat format;
+    uint64_t budget;
+    bool detect_loops;
+    size_t failures;
+    pthread_mutex_t lock;
+} Batch;
+
+typedef struct {
+    Batch *batch;
+    Neander m;
+    Jit jit;
+    uint8_t data[MEMORYSIZE];
+    char line[PATH_MAX * 6 + 256];
+} BatchWorker;
+
+static void add_path(Batch *b, size_t *cap, const char *path) {
+    if (b->count == *cap) {
+        *cap = *cap ? *cap * 2 : 64;
+        b->paths = realloc(b->paths, *cap * sizeof(char *));
+    }
+    b->paths[b->count++] = strdup(path);
+}
+
+static int compare_paths(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Lista de .bin: diretório (todos os *.bin) ou manifesto (um caminho por linha)
+static bool collect_batch(Batch *b, const char *source) {
+    size_t cap = 0;
+    struct stat st;
+
+    if (stat(source, &st) != 0) {
+        perror("Erro ao abrir lote");
+        return false;
+    }
+
+    if (S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(source);
+        if (!dir) {
+            perror("Erro ao abrir diretório");
+            return false;
+        }
+        struct dirent *entry;
+        char path[PATH_MAX];
+        while ((entry = readdir(dir)) != NULL) {
+            size_t len = strlen(entry->d_name);
+            if (len < 4 || strcmp(entry->d_name + len - 4, ".bin") != 0) continue;
+            snprintf(path, sizeof(path), "%s/%s", source, entry->d_name);
+            add_path(b, &cap, path);
+        }
+        closedir(dir);
+        qsort(b->paths, b->count, sizeof(char *), compare_paths);
+        return true;
+    }
+
+    FILE *manifest = fopen(source, "r");
+    if (!manifest) {
+        perror("Erro ao abrir manifesto");
+        return false;
+    }
+    char path[PATH_MAX];
+    while (fgets(path, sizeof(path), manifest)) {
+        path[strcspn(path, "\r\n")] = '\0';
+        if (path[0] == '\0' || path[0] == '#') continue;
+        add_path(b, &cap, path);
+    }
+    fclose(manifest);
+    return true;
+}
+
+// Campo CSV entre aspas, com as aspas internas dobradas (RFC 4180)
+static size_t csv_quote(char *out, size_t cap, const char *s) {
+    size_t len = 0;
+    out[len++] = '"';
+    for (; *s && len + 3 < cap; s++) {
+        if (*s == '"') out[len++] = '"';
+        out[len++] = *s;
+    }
+    out[len++] = '"';
+    out[len] = '\0';
+    return len;
+}
+
+static void run_batch_item(BatchWorker *w, const char *path) {
+    Batch *b = w->batch;
+    const char *status = "ok";
+    bool has_result = false;
+    uint8_t raw = 0;
+    double us = 0;
+
+    int fd = open(path, O_RDONLY);
+    NeanderLoadStatus loaded = fd < 0 ? NEANDER_LOAD_IO : load_fd(fd, &w->m, w->data);
+    if (fd >= 0) close(fd);
+
+    if (loaded == NEANDER_LOAD_IO) {
+        status = "erro_leitura";
+    } else if (loaded == NEANDER_LOAD_HEADER) {
+        status = "cabecalho_invalido";
+    } else {
+        w->m.budget = b->budget;
+        w->m.detect_loops = b->detect_loops;
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        run_engine(b->engine, &w->m, &w->jit);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        us = elapsed_us(&start, &end);
+        if (w->m.status == RUN_LOOP)
+            status = "loop_infinito";
+        else if (w->m.status == RUN_BUDGET)
+            status = "limite_excedido";
+        else if (!(has_result = neander_result(&w->m.core, &raw)))
+            status = "sem_resultado";
+    }
+
+    int n;
+    if (b->format == FORMAT_CSV) {
+        char quoted[PATH_MAX * 2 + 3];
+        csv_quote(quoted, sizeof(quoted), path);
+        n = snprintf(w->line, sizeof(w->line), "%s,%s,", quoted, status);
+        if (has_result)
+            n += snprintf(w->line + n, sizeof(w->line) - n, "0x%02X,%d", raw, (int8_t)raw);
+        else
+            n += snprintf(w->line + n, sizeof(w->line) - n, ",");
+        n += snprintf(w->line + n, sizeof(w->line) - n, ",%llu,%.3f,%d\n",
+                      (unsigned long long)w->m.core.steps, us, w->m.core.pc);
+    } else {
+        char escaped[PATH_MAX * 6];
+        json_escape(escaped, sizeof(escaped), path);
+        n = snprintf(w->line, sizeof(w->line), "{\"file\": \"%s\", \"status\": \"%s\"", escaped, status);
+        if (has_result)
+            n += snprintf(w->line + n, sizeof(w->line) - n, ", \"hex\": \"0x%02X\", \"decimal\": %d", raw, (int8_t)raw);
+        n += snprintf(w->line + n, sizeof(w->line) - n, ", \"instructions\": %llu, \"time_us\": %.3f, \"pc\": %d}\n",
+                      (unsigned long long)w->m.core.steps, us, w->m.core.pc);
+    }
+    if (n >= (int)sizeof(w->line)) n = (int)sizeof(w->line) - 1;
 
-    return 0;
+    pthread_mutex_lock(&b->lock);
+    fwrite(w->line, 1, (size_t)n, stdout);
+    if (strcmp(status, "ok") != 0) b->failures++;
+    pthread_mutex_unlock(&b->lock);
 }
 
+static void *batch_worker(void *arg) {
+    BatchWorker *w = arg;
+    Batch *b = w->batch;
+
+    if (b->engine == ENGINE_JIT)
+        jit_init(&w->jit);
+
+    for (;;) {
+        pthread_mutex_lock(&b->lock);
+        size_t i = b->next++;
+        pthread_mutex_unlock(&b->lock);
+        if (i >= b->count) break;
+        run_batch_item(w, b->paths[i]);
+    }
+
+    jit_release(&w->jit);
+    return NULL;
+}
+
+static int run_batch_mode(const char *source, Engine engine, OutputFormat format, long jobs,
+                          uint64_t budget, bool detect_loops) {
+    Batch b = {0};
+    b.engine = engine;
+    b.format = format;
+    b.budget = budget;
+    b.detect_loops = detect_loops;
+    pthread_mutex_init(&b.lock, NULL);
+
+    if (!collect_batch(&b, source))
+        return 1;
+
+    if (jobs < 1) jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (jobs < 1) jobs = 1;
+    if ((size_t)jobs > b.count && b.count > 0) jobs = (long)b.count;
+
+    if (format == FORMAT_CSV)
+        printf("arquivo,status,hexa,decimal,instrucoes,tempo_us,pc\n");
+    fflush(stdout);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    BatchWorker *workers = calloc((size_t)jobs, sizeof(BatchWorker));
+    pthread_t *threads = calloc((size_t)jobs, sizeof(pthread_t));
+    long started = 0;
+    for (long i = 0; i < jobs; i++) {
+        workers[i].batch = &b;
+        if (pthread_create(&threads[i], NULL, batch_worker, &workers[i]) != 0) {
+            // Sem mais threads: esta roda aqui mesmo e divide a fila com as já criadas
+            fprintf(stderr, "Aviso: só %ld de %ld threads criadas\n", started, jobs);
+            batch_worker(&workers[i]);
+            jobs = started + 1;
+            break;
+        }
+        started++;
+    }
+    for (long i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fflush(stdout);
+    fprintf(stderr, "Lote: %zu programas, %zu falhas, %ld threads, %.3f ms\n",
+            b.count, b.failures, jobs, elapsed_us(&start, &end) / 1e3);
+
+    for (size_t i = 0; i < b.count; i++) free(b.paths[i]);
+    free(b.paths);
+    free(workers);
+    free(threads);
+    pthread_mutex_destroy(&b.lock);
+    return b.failures ? 1 : 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Uso: %s [--engine=switch|threaded|jit] [--stats] [--repeat=N]\n"
+                    "       [--max-steps=N] [--detect-loops] [--no-fuse]\n"
+                    "       [--profile[=saida.json]] [--asm=programa.asm] <arquivo_bin>\n"
+                    "       %s --batch=<manifesto|diretório> [--jobs=N] [--format=csv|jsonl] [--engine=...]\n",
+            prog, prog);
+}
+
+int main(int argc, char *argv[]) {
+    Engine engine = ENGINE_THREADED;
+    bool stats = false;
+    long repeat = 1;
+    const char *path = NULL;
+    const char *profile_path = NULL, *asm_path = NULL;
+    bool profile = false;
+    const char *batch = NULL;
+    OutputFormat format = FORMAT_CSV;
+    long jobs = 0;
+    uint64_t budget = 0;
+    bool detect_loops = false;
+    bool no_fuse = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--engine=switch") == 0) {
+            engine = ENGINE_SWITCH;
+        } else if (strcmp(argv[i], "--engine=threaded") == 0) {
+            engine = ENGINE_THREADED;
+        } else if (strcmp(argv[i], "--engine=jit") == 0) {
+            engine = ENGINE_JIT;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if (strncmp(argv[i], "--repeat=", 9) == 0) {
+            repeat = atol(argv[i] + 9);
+            if (repeat < 1) repeat = 1;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile = true;
+        } else if (strncmp(argv[i], "--profile=", 10) == 0) {
+            profile = true;
+            profile_path = argv[i] + 10;
+        } else if (strncmp(argv[i], "--max-steps=", 12) == 0) {
+            budget = strtoull(argv[i] + 12, NULL, 10);
+        } else if (strcmp(argv[i], "--detect-loops") == 0) {
+            detect_loops = true;
+        } else if (strcmp(argv[i], "--no-fuse") == 0) {
+            no_fuse = true;
+        } else if (strncmp(argv[i], "--batch=", 8) == 0) {
+            batch = argv[i] + 8;
+        } else if (strncmp(argv[i], "--jobs=", 7) == 0) {
+            jobs = atol(argv[i] + 7);
+        } else if (strcmp(argv[i], "--format=csv") == 0) {
+            format = FORMAT_CSV;
+        } else if (strcmp(argv[i], "--format=jsonl") == 0) {
+            format = FORMAT_JSONL;
+        } else if (strncmp(argv[i], "--asm=", 6) == 0) {
+            asm_path = argv[i] + 6;
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    if (!path && !batch) {
+        usage(argv[0]);
+        return 1;
+    }
+
+#if !HAVE_JIT
+    if (engine == ENGINE_JIT) {
+        fprintf(stderr, "JIT indisponível nesta plataforma; usando o motor threaded\n");
+        engine = ENGINE_THREADED;
+    }
+#endif
+
+    if (batch)
+        return run_batch_mode(batch, engine, format, jobs, budget, detect_loops);
+
+    static Neander image, m;
+    if (!load_program(path, &image))
+        return 1;
+    image.budget = budget;
+    image.detect_loops = detect_loops;
+    image.no_fuse = no_fuse;
+
+    if (profile)
+        return run_profile_mode(path, &image, profile_path, asm_path);
+
+    static Jit jit;
+    if (engine == ENGINE_JIT)
+        jit_init(&jit);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long r = 0; r < repeat; r++) {
+        m = image;
+        run_engine(engine, &m, &jit);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    print_result(&m);
+
+    if (stats) {
+        static const char *const names[] = {"switch", "threaded", "jit"};
+        printf("Motor: %s\n", names[engine]);
+        printf("Instruções executadas: %llu\n", (unsigned long long)m.core.steps);
+        if (engine == ENGINE_THREADED)
+            printf("Instruções fundidas: %llu (%.1f%%)\n", (unsigned long long)m.fused,
+                   m.core.steps ? 100.0 * (double)m.fused / (double)m.core.steps : 0.0);
+        printf("Tempo por execução: %.3f us\n", elapsed_us(&start, &end) / repeat);
+    }
+
+    jit_release(&jit);
+
+    return m.status == RUN_HALTED ? 0 : 2;
+}
@@ -0,0 +1,364 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+/*
+ * Fuzzing diferencial do pipeline LPN -> ASM -> BIN. Gera programas
+ * PROGRAMA/INICIO/FIM aleatórios com expressões aninhadas (+ - * / %), passa cada um
+ * por compilador, assembler e executor e compara o resultado impresso com
+ * um avaliador de referência em 8 bits (como evalNode do bfc.c, mas com
+ * a volta em 256 a cada operação). Também registra o tempo de compilação,
+ * de montagem, as instruções executadas e o tempo de execução de cada
+ * programa, uma linha CSV por caso.
+ */
+
+#define MAX_NODES 512
+#define MAX_VARS 4
+#define OUTPUT_SIZE 4096
+#define MAX_COMPILER_OPTS 8
+
+typedef struct {
+    char op;        // 0 = literal, 'v' = variável, senão + - * / %
+    uint8_t value;  // literal ou índice da variável
+    int left, right;
+} Node;
+
+typedef struct {
+    Node nodes[MAX_NODES];
+    int count;
+    int vars;           // variáveis já definidas
+    uint64_t rng;
+} Generator;
+
+typedef struct {
+    uint64_t seed;
+    long count;
+    int depth;
+    int max_literal;
+    const char *ops;
+    const char *dir;
+    const char *bin_dir;
+    const char *csv;
+    uint64_t max_steps;
+    bool keep;
+    bool direct;        // compilador --emit=bin, sem passar pelo assembler
+    char *compiler_opts[MAX_COMPILER_OPTS];
+    int compiler_opt_count;
+} Options;
+
+static uint64_t next_random(Generator *g) {
+    // xorshift64*
+    g->rng ^= g->rng >> 12;
+    g->rng ^= g->rng << 25;
+    g->rng ^= g->rng >> 27;
+    return g->rng * 0x2545F4914F6CDD1DULL;
+}
+
+static int random_below(Generator *g, int n) {
+    return (int)(next_random(g) % (uint64_t)n);
+}
+
+static int new_node(Generator *g, char op, uint8_t value, int left, int right) {
+    if (g->count == MAX_NODES) return -1;
+    Node *n = &g->nodes[g->count];
+    n->op = op;
+    n->value = value;
+    n->left = left;
+    n->right = right;
+    return g->count++;
+}
+
+// Folha: literal ou variável já atribuída
+static int gen_leaf(Generator *g, const Options *o) {
+    if (g->vars > 0 && random_below(g, 2) == 0)
+        return new_node(g, 'v', (uint8_t)random_below(g, g->vars), -1, -1);
+    return new_node(g, 0, (uint8_t)random_below(g, o->max_literal + 1), -1, -1);
+}
+
+static int gen_expr(Generator *g, const Options *o, int depth) {
+    if (depth == 0 || g->count + 3 > MAX_NODES || random_below(g, 4) == 0)
+        return gen_leaf(g, o);
+
+    char op = o->ops[random_below(g, (int)strlen(o->ops))];
+    int left = gen_expr(g, o, depth - 1);
+    int right = gen_expr(g, o, depth - 1);
+    if (left < 0 || right < 0) return gen_leaf(g, o);
+    return new_node(g, op, 0, left, right);
+}
+
+static void print_expr(FILE *f, const Generator *g, int idx, bool top) {
+    const Node *n = &g->nodes[idx];
+    if (n->op == 0) {
+        fprintf(f, "%d", n->value);
+    } else if (n->op == 'v') {
+        fprintf(f, "%c", 'a' + n->value);
+    } else {
+        if (!top) fputc('(', f);
+        print_expr(f, g, n->left, false);
+        fprintf(f, " %c ", n->op);
+        print_expr(f, g, n->right, false);
+        if (!top) fputc(')', f);
+    }
+}
+
+// Avaliador de referência: toda operação volta em 256; divisão sem sinal, x / 0 = 0 e x % 0 = x
+static uint8_t eval_expr(const Generator *g, int idx, const uint8_t *vals) {
+    const Node *n = &g->nodes[idx];
+    if (n->op == 0) return n->value;
+    if (n->op == 'v') return vals[n->value];
+
+    uint8_t l = eval_expr(g, n->left, vals);
+    uint8_t r = eval_expr(g, n->right, vals);
+    switch (n->op) {
+        case '+': return (uint8_t)(l + r);
+        case '-': return (uint8_t)(l - r);
+        case '*': return (uint8_t)(l * r);
+        case '/': return r ? (uint8_t)(l / r) : 0;
+        case '%': return r ? (uint8_t)(l % r) : l;
+    }
+    return 0;
+}
+
+// Escreve o programa em path e devolve o resultado esperado
+static uint8_t gen_program(Generator *g, const Options *o, const char *path, long id) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+
+    uint8_t vals[MAX_VARS];
+    g->count = 0;
+    g->vars = 0;
+
+    fprintf(f, "PROGRAMA \"caso%ld\":\nINICIO\n", id);
+    int nvars = random_below(g, MAX_VARS + 1);
+    for (int v = 0; v < nvars; v++) {
+        int e = random_below(g, 3) == 0 ? gen_expr(g, o, o->depth > 1 ? o->depth - 1 : 1)
+                                         : gen_leaf(g, o);
+        fprintf(f, "%c = ", 'a' + v);
+        print_expr(f, g, e, true);
+        fputc('\n', f);
+        vals[v] = eval_expr(g, e, vals);
+        g->vars++;
+    }
+
+    int res = gen_expr(g, o, o->depth);
+    fprintf(f, "RES = ");
+    print_expr(f, g, res, true);
+    fprintf(f, "\nFIM\n");
+    fclose(f);
+
+    return eval_expr(g, res, vals);
+}
+
+static double elapsed_us(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e6 + (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+/*
+ * Executa argv[0] com a saída padrão capturada em out (ou descartada se
+ * out == NULL). Devolve o código de saída, ou -1 se o processo não terminou
+ * normalmente.
+ */
+static int run_tool(char *const argv[], char *out, size_t size, double *us) {
+    int fds[2] = {-1, -1};
+    if (out && pipe(fds) != 0) {
+        perror("pipe");
+        exit(1);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        int sink = open("/dev/null", O_WRONLY);
+        dup2(out ? fds[1] : sink, STDOUT_FILENO);
+        dup2(sink, STDERR_FILENO);
+        if (out) {
+            close(fds[0]);
+            close(fds[1]);
+        }
+        execv(argv[0], argv);
+        _exit(127);
+    }
+
+    size_t len = 0;
+    if (out) {
+        close(fds[1]);
+        ssize_t r;
+        while ((r = read(fds[0], out + len, size - 1 - len)) > 0)
+            len += (size_t)r;
+        close(fds[0]);
+        out[len] = '\0';
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *us = elapsed_us(&start, &end);
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static bool file_exists(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Uso: %s [--seed=N] [--count=N] [--depth=N] [--ops=+-*/%%] [--max-literal=N]\n"
+                    "       [--dir=fuzz_out] [--bin-dir=.] [--csv=saida.csv] [--max-steps=N] [--keep]\n"
+                    "       [--compiler-opt=OPÇÃO]... [--direct]\n",
+            prog);
+}
+
+int main(int argc, char *argv[]) {
+    Options o = {
+        .seed = 1, .count = 200, .depth = 3, .max_literal = 15, .ops = "+-*/%",
+        .dir = "fuzz_out", .bin_dir = ".", .csv = NULL, .max_steps = 1000000, .keep = false,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--seed=", 7) == 0) {
+            o.seed = strtoull(argv[i] + 7, NULL, 10);
+        } else if (strncmp(argv[i], "--count=", 8) == 0) {
+            o.count = atol(argv[i] + 8);
+        } else if (strncmp(argv[i], "--depth=", 8) == 0) {
+            o.depth = atoi(argv[i] + 8);
+        } else if (strncmp(argv[i], "--ops=", 6) == 0) {
+            o.ops = argv[i] + 6;
+        } else if (strncmp(argv[i], "--max-literal=", 14) == 0) {
+            o.max_literal = atoi(argv[i] + 14);
+        } else if (strncmp(argv[i], "--dir=", 6) == 0) {
+            o.dir = argv[i] + 6;
+        } else if (strncmp(argv[i], "--bin-dir=", 10) == 0) {
+            o.bin_dir = argv[i] + 10;
+        } else if (strncmp(argv[i], "--csv=", 6) == 0) {
+            o.csv = argv[i] + 6;
+        } else if (strncmp(argv[i], "--max-steps=", 12) == 0) {
+            o.max_steps = strtoull(argv[i] + 12, NULL, 10);
+        } else if (strcmp(argv[i], "--keep") == 0) {
+            o.keep = true;
+        } else if (strcmp(argv[i], "--direct") == 0) {
+            o.direct = true;
+        } else if (strncmp(argv[i], "--compiler-opt=", 15) == 0 &&
+                   o.compiler_opt_count < MAX_COMPILER_OPTS) {
+            o.compiler_opts[o.compiler_opt_count++] = argv[i] + 15;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (o.count < 1 || o.depth < 0 || o.max_literal < 0 || o.max_literal > 255 ||
+        strspn(o.ops, "+-*/%") != strlen(o.ops) || !*o.ops) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    mkdir(o.dir, 0755);
+
+    FILE *csv = o.csv ? fopen(o.csv, "w") : stdout;
+    if (!csv) {
+        perror(o.csv);
+        return 1;
+    }
+    fprintf(csv, "caso,status,esperado,obtido,compilacao_us,montagem_us,instrucoes,execucao_us,vm_us\n");
+
+    char compiler[PATH_MAX], assembler[PATH_MAX], executor[PATH_MAX];
+    snprintf(compiler, sizeof(compiler), "%s/compilador", o.bin_dir);
+    snprintf(assembler, sizeof(assembler), "%s/assembler", o.bin_dir);
+    snprintf(executor, sizeof(executor), "%s/executor", o.bin_dir);
+
+    char steps_opt[64];
+    snprintf(steps_opt, sizeof(steps_opt), "--max-steps=%llu", (unsigned long long)o.max_steps);
+
+    Generator g = {.rng = o.seed * 0x9E3779B97F4A7C15ULL | 1};
+    long failures = 0;
+    static char output[OUTPUT_SIZE];
+
+    for (long id = 0; id < o.count; id++) {
+        char lpn[PATH_MAX], asmf[PATH_MAX], bin[PATH_MAX];
+        snprintf(lpn, sizeof(lpn), "%s/caso%04ld.lpn", o.dir, id);
+        snprintf(asmf, sizeof(asmf), "%s/caso%04ld.asm", o.dir, id);
+        snprintf(bin, sizeof(bin), "%s/caso%04ld.bin", o.dir, id);
+        remove(asmf);
+        remove(bin);
+
+        uint8_t expected = gen_program(&g, &o, lpn, id);
+        const char *status = "ok";
+        int got = -1;
+        double compile_us = 0, assemble_us = 0, run_us = 0, vm_us = 0;
+        unsigned long long steps = 0;
+
+        char *compile_argv[MAX_COMPILER_OPTS + 4] = {compiler};
+        int compile_argc = 1;
+        for (int i = 0; i < o.compiler_opt_count; i++)
+            compile_argv[compile_argc++] = o.compiler_opts[i];
+        if (o.direct)
+            compile_argv[compile_argc++] = "--emit=bin";
+        compile_argv[compile_argc] = lpn;
+        char *assemble_argv[] = {assembler, asmf, bin, NULL};
+        char *run_argv[] = {executor, "--stats", "--detect-loops", steps_opt, bin, NULL};
+
+        if (run_tool(compile_argv, NULL, 0, &compile_us) != 0 || !file_exists(o.direct ? bin : asmf)) {
+            status = "erro_compilacao";
+        } else if (!o.direct &&
+                   (run_tool(assemble_argv, NULL, 0, &assemble_us) != 0 || !file_exists(bin))) {
+            status = "erro_montagem";
+        } else {
+            int code = run_tool(run_argv, output, sizeof(output), &run_us);
+            const char *p;
+            unsigned hex;
+
+            if ((p = strstr(output, "Instruções executadas: ")))
+                steps = strtoull(p + strlen("Instruções executadas: "), NULL, 10);
+            if ((p = strstr(output, "Tempo por execução: ")))
+                vm_us = strtod(p + strlen("Tempo por execução: "), NULL);
+
+            if (strstr(output, "Loop infinito"))
+                status = "loop_infinito";
+            else if (strstr(output, "Limite de"))
+                status = "limite_instrucoes";
+            else if (code != 0 || !(p = strstr(output, "Conta final (hexa) = 0x")) ||
+                     sscanf(p + strlen("Conta final (hexa) = 0x"), "%x", &hex) != 1)
+                status = "erro_execucao";
+            else if ((got = (int)hex) != expected)
+                status = "divergente";
+        }
+
+        bool ok = strcmp(status, "ok") == 0;
+        if (!ok) failures++;
+
+        fprintf(csv, "caso%04ld,%s,%u,", id, status, expected);
+        if (got >= 0) fprintf(csv, "%d", got);
+        fprintf(csv, ",%.1f,%.1f,%llu,%.1f,%.3f\n", compile_us, assemble_us, steps, run_us, vm_us);
+        fflush(csv);
+
+        // Casos que passaram só ficam no disco com --keep
+        if (ok && !o.keep) {
+            remove(lpn);
+            remove(asmf);
+            remove(bin);
+        }
+    }
+
+    if (csv != stdout) fclose(csv);
+    fprintf(stderr, "Fuzzing: %ld programas, %ld falhas (semente %llu, casos com falha em %s/)\n",
+            o.count, failures, (unsigned long long)o.seed, o.dir);
+    return failures ? 1 : 0;
+}
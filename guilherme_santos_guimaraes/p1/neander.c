@@ -0,0 +1,561 @@
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+
+#include "neander.h"
+
+static void* grow(void* ptr, size_t size) {
+    ptr = realloc(ptr, size);
+    if (!ptr) {
+        fprintf(stderr, "Erro: memória insuficiente\n");
+        exit(1);
+    }
+    return ptr;
+}
+
+// Grava a mensagem de erro, com a linha quando conhecida
+static bool fail(NeanderAssembler* a, int line, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(a->error, sizeof(a->error), format, args);
+    va_end(args);
+    if (line > 0 && len >= 0 && (size_t)len < sizeof(a->error))
+        snprintf(a->error + len, sizeof(a->error) - len, " (linha %d)", line);
+    return false;
+}
+
+void neander_init(NeanderAssembler* a) {
+    memset(a, 0, sizeof(*a));
+    // Cabeçalho NDR
+    a->memory[0] = 0x03;
+    a->memory[1] = 'N';
+    a->memory[2] = 'D';
+    a->memory[3] = 'R';
+    a->pc = HEADER_SIZE;
+    a->code_end = HEADER_SIZE;
+    a->var_ptr = VAR_START;
+}
+
+void neander_free(NeanderAssembler* a) {
+    for (int i = 0; i < a->fixup_count; i++)
+        free(a->fixups[i].name);
+    free(a->symbols);
+    free(a->symbol_index);
+    free(a->names);
+    free(a->fixups);
+    a->symbols = NULL;
+    a->symbol_index = NULL;
+    a->names = NULL;
+    a->fixups = NULL;
+    a->symbol_count = a->symbol_capacity = a->index_capacity = 0;
+    a->fixup_count = a->fixup_capacity = 0;
+    a->names_len = a->names_capacity = 0;
+}
+
+uint8_t neander_opcode(const char* mnemonic) {
+    if (strcasecmp(mnemonic, "NOP") == 0) return OP_NOP;
+    if (strcasecmp(mnemonic, "STA") == 0) return OP_STA;
+    if (strcasecmp(mnemonic, "LDA") == 0) return OP_LDA;
+    if (strcasecmp(mnemonic, "ADD") == 0) return OP_ADD;
+    if (strcasecmp(mnemonic, "SUB") == 0) return OP_SUB;
+    if (strcasecmp(mnemonic, "OR")  == 0) return OP_OR;
+    if (strcasecmp(mnemonic, "AND") == 0) return OP_AND;
+    if (strcasecmp(mnemonic, "NOT") == 0) return OP_NOT;
+    if (strcasecmp(mnemonic, "JMP") == 0) return OP_JMP;
+    if (strcasecmp(mnemonic, "JMN") == 0) return OP_JMN;
+    if (strcasecmp(mnemonic, "JMZ") == 0) return OP_JMZ;
+    if (strcasecmp(mnemonic, "HLT") == 0) return OP_HLT;
+    return OP_INVALID;
+}
+
+bool neander_has_operand(uint8_t opcode) {
+    return opcode != OP_HLT && opcode != OP_NOP && opcode != OP_NOT;
+}
+
+bool neander_is_branch(uint8_t opcode) {
+    return opcode == OP_JMP || opcode == OP_JMN || opcode == OP_JMZ;
+}
+
+uint8_t neander_operand_word(int addr) {
+    return (addr - HEADER_SIZE) / 2;
+}
+
+/*
+ * Tabela de símbolos: entradas num vetor que cresce sob demanda e um índice
+ * por endereçamento aberto (sondagem linear) com o dobro do tamanho, no
+ * mínimo. Os nomes ficam internados num único buffer e as entradas guardam
+ * só o deslocamento, que continua válido quando o buffer é realocado.
+ */
+
+// FNV-1a
+static uint32_t hash_name(const char* name, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (uint8_t)name[i]) * 16777619u;
+    return h;
+}
+
+const char* neander_symbol_name(const NeanderAssembler* a, const NeanderSymbol* sym) {
+    return a->names + sym->name;
+}
+
+static void rebuild_index(NeanderAssembler* a, int capacity) {
+    free(a->symbol_index);
+    a->symbol_index = grow(NULL, capacity * sizeof(int));
+    a->index_capacity = capacity;
+    memset(a->symbol_index, -1, capacity * sizeof(int));
+
+    for (int i = 0; i < a->symbol_count; i++) {
+        uint32_t slot = a->symbols[i].hash & (capacity - 1);
+        while (a->symbol_index[slot] >= 0)
+            slot = (slot + 1) & (capacity - 1);
+        a->symbol_index[slot] = i;
+    }
+}
+
+// Devolve a posição do nome no índice: a entrada existente ou o slot vazio onde ela entraria
+static uint32_t find_slot(const NeanderAssembler* a, const char* name, size_t len, uint32_t hash) {
+    uint32_t slot = hash & (a->index_capacity - 1);
+    while (a->symbol_index[slot] >= 0) {
+        const NeanderSymbol* sym = &a->symbols[a->symbol_index[slot]];
+        if (sym->hash == hash && sym->name_len == len &&
+            memcmp(neander_symbol_name(a, sym), name, len) == 0)
+            break;
+        slot = (slot + 1) & (a->index_capacity - 1);
+    }
+    return slot;
+}
+
+const NeanderSymbol* neander_find_symbol(const NeanderAssembler* a, const char* name) {
+    if (!a->index_capacity) return NULL;
+    size_t len = strlen(name);
+    int idx = a->symbol_index[find_slot(a, name, len, hash_name(name, len))];
+    return idx >= 0 ? &a->symbols[idx] : NULL;
+}
+
+// Devolve false se o nome já existia
+static bool add_symbol(NeanderAssembler* a, const char* name, int address, SymbolKind kind, bool defined) {
+    // Mantém a carga do índice abaixo de 1/2
+    if (2 * (a->symbol_count + 1) > a->index_capacity)
+        rebuild_index(a, a->index_capacity ? 2 * a->index_capacity : 64);
+
+    size_t len = strlen(name);
+    uint32_t hash = hash_name(name, len);
+    uint32_t slot = find_slot(a, name, len, hash);
+    if (a->symbol_index[slot] >= 0)
+        return false; // Já existe
+
+    if (a->symbol_count == a->symbol_capacity) {
+        a->symbol_capacity = a->symbol_capacity ? 2 * a->symbol_capacity : 64;
+        a->symbols = grow(a->symbols, a->symbol_capacity * sizeof(NeanderSymbol));
+    }
+    if (a->names_len + len + 1 > a->names_capacity) {
+        while (a->names_len + len + 1 > a->names_capacity)
+            a->names_capacity = a->names_capacity ? 2 * a->names_capacity : 1024;
+        a->names = grow(a->names, a->names_capacity);
+    }
+
+    NeanderSymbol* sym = &a->symbols[a->symbol_count];
+    memcpy(a->names + a->names_len, name, len + 1);
+    sym->name = a->names_len;
+    sym->name_len = len;
+    sym->hash = hash;
+    sym->address = address;
+    sym->kind = kind;
+    sym->defined = defined;
+    a->names_len += len + 1;
+    a->symbol_index[slot] = a->symbol_count++;
+    return true;
+}
+
+// Reserva a próxima palavra de dados; a área vai de VAR_START ao fim da memória
+static int alloc_var(NeanderAssembler* a, const char* name, int line) {
+    if (a->var_ptr % 2 != 0) a->var_ptr++;  // alinhamento
+    if (a->var_ptr + 2 > MEM_SIZE) {
+        fail(a, line, "Erro: sem espaço para a variável %s (área de dados cheia)", name);
+        return -1;
+    }
+    int addr = a->var_ptr;
+    a->var_ptr += 2;
+    return addr;
+}
+
+static void add_fixup(NeanderAssembler* a, int at, const char* name, int line, bool branch) {
+    if (a->fixup_count == a->fixup_capacity) {
+        a->fixup_capacity = a->fixup_capacity ? 2 * a->fixup_capacity : 64;
+        a->fixups = grow(a->fixups, a->fixup_capacity * sizeof(NeanderFixup));
+    }
+    NeanderFixup* f = &a->fixups[a->fixup_count++];
+    f->at = at;
+    f->name = strdup(name);
+    f->line = line;
+    f->branch = branch;
+    if (!f->name) {
+        fprintf(stderr, "Erro: memória insuficiente\n");
+        exit(1);
+    }
+}
+
+bool neander_org(NeanderAssembler* a, int word, int line) {
+    // .ORG n posiciona o código na palavra n (byte 2n + 4), como os operandos
+    int org = word * 2 + HEADER_SIZE;
+    if (org < HEADER_SIZE || org >= VAR_START)
+        return fail(a, line, "Erro: .ORG fora da área de programa");
+    a->pc = org;
+    return true;
+}
+
+bool neander_define_data(NeanderAssembler* a, const char* name, int value, int line) {
+    if (neander_find_symbol(a, name)) return true; // Já existe
+    int addr = alloc_var(a, name, line);
+    if (addr < 0) return false;
+    add_symbol(a, name, addr, SYM_DATA, true);
+    a->memory[addr] = value;
+    a->memory[addr + 1] = 0x00;
+    return true;
+}
+
+bool neander_define_label(NeanderAssembler* a, const char* name, int line) {
+    if (!add_symbol(a, name, a->pc, SYM_LABEL, true))
+        return fail(a, line, "Erro: símbolo %s redefinido", name);
+    return true;
+}
+
+bool neander_emit(NeanderAssembler* a, uint8_t opcode, const char* operand, int line) {
+    // O pc do executor tem 8 bits: o código precisa caber antes de VAR_START
+    if (a->pc + 4 > VAR_START)
+        return fail(a, line, "Erro: código ultrapassa a área de programa");
+    if (neander_has_operand(opcode) && !operand)
+        return fail(a, line, "Erro: instrução sem operando");
+
+    a->memory[a->pc++] = opcode;
+    a->memory[a->pc++] = 0x00;
+    a->memory[a->pc++] = 0x00;
+    a->memory[a->pc++] = 0x00;
+    if (a->pc > a->code_end) a->code_end = a->pc;
+    if (neander_has_operand(opcode))
+        add_fixup(a, a->pc - 2, operand, line, neander_is_branch(opcode));
+    return true;
+}
+
+/*
+ * Segundo passo: com todos os rótulos e dados conhecidos, preenche os
+ * operandos pendentes. Nomes que não são rótulo nem dado declarado viram
+ * variáveis novas, na ordem da primeira referência; desvios para nomes
+ * desconhecidos são erro.
+ */
+static bool resolve_fixups(NeanderAssembler* a) {
+    for (int i = 0; i < a->fixup_count; i++) {
+        NeanderFixup* f = &a->fixups[i];
+        const NeanderSymbol* sym = neander_find_symbol(a, f->name);
+        if (f->branch && (!sym || sym->kind != SYM_LABEL))
+            return fail(a, f->line, "Erro: rótulo %s não definido", f->name);
+
+        int addr;
+        if (sym) {
+            addr = sym->address;
+        } else {
+            // Se não existe, cria nova entrada
+            addr = alloc_var(a, f->name, f->line);
+            if (addr < 0) return false;
+            add_symbol(a, f->name, addr, SYM_DATA, false);
+        }
+        a->memory[f->at] = neander_operand_word(addr);
+    }
+    for (int i = 0; i < a->fixup_count; i++)
+        free(a->fixups[i].name);
+    a->fixup_count = 0;
+    return true;
+}
+
+bool neander_finish(NeanderAssembler* a, int line) {
+    // Garante que termina com HLT
+    if (a->memory[a->pc - 4] != OP_HLT && !neander_emit(a, OP_HLT, NULL, line))
+        return false;
+    return resolve_fixups(a);
+}
+
+/*
+ * Assembler de texto: percorre o .asm linha a linha e repassa diretivas,
+ * dados, rótulos e instruções para as funções acima. Cada linha é copiada
+ * para um buffer próprio e quebrada com strtok_r, então o texto de entrada
+ * não é alterado e chamadas em threads diferentes não interferem.
+ */
+static bool assemble_line(NeanderAssembler* a, char* line, int lineno, bool* in_data, bool* in_code) {
+    char* save;
+    char* token = strtok_r(line, " \t\r\n", &save);
+    if (!token || token[0] == ';') return true;
+
+    if (strcasecmp(token, ".DATA") == 0) {
+        *in_data = true;
+        *in_code = false;
+        return true;
+    } else if (strcasecmp(token, ".CODE") == 0) {
+        *in_code = true;
+        *in_data = false;
+        return true;
+    } else if (strcasecmp(token, ".ORG") == 0) {
+        // .ORG n posiciona o código na palavra n (byte 2n + 4), como os operandos
+        char* val = strtok_r(NULL, " \t\r\n", &save);
+        return neander_org(a, val ? atoi(val) : 0, lineno);
+    }
+
+    if (*in_data) {
+        char* name = token;
+        strtok_r(NULL, " \t\r\n", &save); // DB
+        char* val = strtok_r(NULL, " \t\r\n", &save);
+        int value = (val && strcmp(val, "?") != 0) ? atoi(val) : 0;
+        return neander_define_data(a, name, value, lineno);
+    }
+    if (!*in_code) return true;
+
+    // Rótulo: "NOME:" sozinho ou seguido de uma instrução
+    char* colon = strchr(token, ':');
+    if (colon) {
+        *colon = '\0';
+        if (!neander_define_label(a, token, lineno))
+            return false;
+        token = colon[1] ? colon + 1 : strtok_r(NULL, " \t\r\n", &save);
+        if (!token || token[0] == ';') return true;
+    }
+
+    uint8_t opcode = neander_opcode(token);
+    if (opcode == OP_INVALID) return true;
+
+    char* arg = NULL;
+    if (neander_has_operand(opcode)) {
+        arg = strtok_r(NULL, " \t\r\n", &save);
+        if (!arg || arg[0] == ';')
+            return fail(a, lineno, "Erro: %s sem operando", token);
+    }
+    return neander_emit(a, opcode, arg, lineno);
+}
+
+bool neander_assemble(NeanderAssembler* a, const char* text, size_t len) {
+    neander_init(a);
+
+    char* line = NULL;
+    size_t line_capacity = 0;
+    int lineno = 0;
+    bool in_data = false, in_code = false, ok = true;
+
+    // Primeiro passo: monta o código, define rótulos e dados e anota os operandos pendentes
+    for (size_t pos = 0; pos < len && ok; ) {
+        const char* end = memchr(text + pos, '\n', len - pos);
+        size_t line_len = end ? (size_t)(end - (text + pos)) : len - pos;
+        if (line_len + 1 > line_capacity) {
+            line_capacity = line_len + 1;
+            line = grow(line, line_capacity);
+        }
+        memcpy(line, text + pos, line_len);
+        line[line_len] = '\0';
+        pos += line_len + 1;
+        ok = assemble_line(a, line, ++lineno, &in_data, &in_code);
+    }
+    free(line);
+
+    // Segundo passo: HLT final e backpatch dos operandos
+    return ok && neander_finish(a, lineno);
+}
+
+void neander_write_v1(const NeanderAssembler* a, FILE* out) {
+    fwrite(a->memory, 1, MEM_SIZE, out);
+}
+
+static void put_u16(uint8_t* out, int value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+}
+
+/*
+ * Monta a imagem no formato v2:
+ *   0  magic 03 'N' 'D' 'R'
+ *   4  marcador 0xFF, versão
+ *   6  tamanho do cabeçalho, entrada, endereço de RESULT, nº de seções, reservado (u16 LE)
+ *   16 seções: tipo, flags, endereço na memória, tamanho, deslocamento no arquivo
+ * seguidas dos dados de código, dados e símbolos ({endereço u16, tipo, tamanho, nome}).
+ */
+uint8_t* neander_image_v2(const NeanderAssembler* a, size_t* len) {
+    uint8_t header[NDR_V2_HEADER + 3 * NDR_SECTION_LEN] = {0};
+    uint8_t* symbols = grow(NULL, 4 * a->symbol_count + a->names_len + 1);
+    int symbols_len = 0;
+    const NeanderSymbol* result_sym = neander_find_symbol(a, "RESULT");
+    int result = result_sym ? result_sym->address : NO_ADDRESS;
+
+    for (int i = 0; i < a->symbol_count; i++) {
+        const NeanderSymbol* sym = &a->symbols[i];
+        int name_len = sym->name_len > 255 ? 255 : sym->name_len;  // tamanho é u8
+        put_u16(symbols + symbols_len, sym->address);
+        symbols[symbols_len + 2] = sym->kind;
+        symbols[symbols_len + 3] = name_len;
+        memcpy(symbols + symbols_len + 4, neander_symbol_name(a, sym), name_len);
+        symbols_len += 4 + name_len;
+    }
+
+    int code_len = a->code_end - HEADER_SIZE;
+    int data_len = a->var_ptr - VAR_START;
+    int offset = sizeof(header);
+
+    memcpy(header, a->memory, HEADER_SIZE);
+    header[4] = NDR_V2_MARKER;
+    header[5] = NDR_VERSION;
+    put_u16(header + 6, sizeof(header));
+    put_u16(header + 8, HEADER_SIZE);
+    put_u16(header + 10, result);
+    put_u16(header + 12, 3);
+
+    uint8_t* section = header + NDR_V2_HEADER;
+    section[0] = SECTION_CODE;
+    put_u16(section + 2, HEADER_SIZE);
+    put_u16(section + 4, code_len);
+    put_u16(section + 6, offset);
+    offset += code_len;
+
+    section += NDR_SECTION_LEN;
+    section[0] = SECTION_DATA;
+    put_u16(section + 2, VAR_START);
+    put_u16(section + 4, data_len);
+    put_u16(section + 6, offset);
+    offset += data_len;
+
+    section += NDR_SECTION_LEN;
+    section[0] = SECTION_SYMBOLS;
+    put_u16(section + 2, 0);
+    put_u16(section + 4, symbols_len);
+    put_u16(section + 6, offset);
+
+    uint8_t* image = grow(NULL, offset + symbols_len);
+    memcpy(image, header, sizeof(header));
+    memcpy(image + sizeof(header), a->memory + HEADER_SIZE, code_len);
+    memcpy(image + sizeof(header) + code_len, a->memory + VAR_START, data_len);
+    memcpy(image + offset, symbols, symbols_len);
+    free(symbols);
+    *len = offset + symbols_len;
+    return image;
+}
+
+void neander_write_v2(const NeanderAssembler* a, FILE* out) {
+    size_t len;
+    uint8_t* image = neander_image_v2(a, &len);
+    fwrite(image, 1, len, out);
+    free(image);
+}
+
+/*
+ * Execução: o loader e o interpretador switch usados também pelo
+ * executor. O NOT avança só 2 bytes, como no executor original.
+ */
+static uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+NeanderLoadStatus neander_load(NeanderMachine* m, const uint8_t* image, size_t len,
+                               NeanderFetch fetch, void* source) {
+    memset(m, 0, sizeof(*m));
+    m->result_addr = -1;
+    if (len < HEADER_SIZE || memcmp(image, "\x03NDR", HEADER_SIZE) != 0)
+        return NEANDER_LOAD_HEADER;
+
+    if (len == HEADER_SIZE || image[HEADER_SIZE] != NDR_V2_MARKER) {
+        size_t size = len > NEANDER_RUN_MEMORY ? NEANDER_RUN_MEMORY : len;
+        memcpy(m->bytes + HEADER_SIZE, image + HEADER_SIZE, size - HEADER_SIZE);
+        return NEANDER_LOAD_OK;
+    }
+
+    if (len < NDR_V2_HEADER || image[5] != NDR_VERSION)
+        return NEANDER_LOAD_HEADER;
+
+    uint16_t entry = get_u16(image + 8);
+    uint16_t result = get_u16(image + 10);
+    uint16_t sections = get_u16(image + 12);
+    if (entry >= 256 || entry % 2 != 0 || NDR_V2_HEADER + (size_t)sections * NDR_SECTION_LEN > len)
+        return NEANDER_LOAD_HEADER;
+
+    for (int i = 0; i < sections; i++) {
+        const uint8_t* sec = image + NDR_V2_HEADER + i * NDR_SECTION_LEN;
+        uint16_t addr = get_u16(sec + 2), size = get_u16(sec + 4), offset = get_u16(sec + 6);
+
+        if (sec[0] != SECTION_CODE && sec[0] != SECTION_DATA) continue;
+        if (addr + size > NEANDER_RUN_MEMORY) return NEANDER_LOAD_HEADER;
+        if ((size_t)offset + size <= len)
+            memcpy(m->bytes + addr, image + offset, size);
+        else if (!fetch)
+            return NEANDER_LOAD_HEADER;
+        else if (!fetch(source, m->bytes + addr, size, offset))
+            return NEANDER_LOAD_IO;
+    }
+
+    m->pc = (uint8_t)entry;
+    if (result != NO_ADDRESS && result < NEANDER_RUN_MEMORY)
+        m->result_addr = result;
+    return NEANDER_LOAD_OK;
+}
+
+bool neander_step(NeanderMachine* m, uint64_t limit) {
+    uint8_t* bytes = m->bytes;
+    uint8_t ac = m->ac, pc = m->pc;
+    uint64_t steps = m->steps;
+    bool halted;
+
+    for (;;) {
+        if (bytes[pc] == OP_HLT) {
+            halted = true;
+            break;
+        }
+        if (steps >= limit) {
+            halted = false;
+            break;
+        }
+        uint16_t addr = bytes[pc + 2] * 2 + HEADER_SIZE;
+        steps++;
+
+        switch (bytes[pc]) {
+            case OP_STA: bytes[addr] = ac; break;
+            case OP_LDA: ac = bytes[addr]; break;
+            case OP_ADD: ac += bytes[addr]; break;
+            case OP_SUB: ac -= bytes[addr]; break;
+            case OP_OR:  ac |= bytes[addr]; break;
+            case OP_AND: ac &= bytes[addr]; break;
+            case OP_NOT: ac = ~ac; pc += 2; continue;
+            case OP_JMP: pc = addr; continue;
+            case OP_JMN: if (ac & 0x80) { pc = addr; continue; } break;
+            case OP_JMZ: if (ac == 0) { pc = addr; continue; } break;
+        }
+        pc += 4;
+    }
+
+    m->ac = ac;
+    m->pc = pc;
+    m->z = (ac == 0);
+    m->n = (ac & 0x80) != 0;
+    m->steps = steps;
+    return halted;
+}
+
+bool neander_result(const NeanderMachine* m, uint8_t* value) {
+    if (m->result_addr >= 0) {
+        *value = m->bytes[m->result_addr];
+        return true;
+    }
+
+    // v1 não diz onde está RESULT: vale a primeira palavra igual ao acumulador
+    for (int i = HEADER_SIZE; i < NEANDER_RUN_MEMORY; i += 2) {
+        if (m->bytes[i] == m->ac) {
+            *value = m->bytes[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool neander_run(const uint8_t* image, size_t len, uint64_t budget, NeanderRun* run) {
+    memset(run, 0, sizeof(*run));
+    if (neander_load(&run->machine, image, len, NULL, NULL) != NEANDER_LOAD_OK)
+        return false;
+
+    bool halted = neander_step(&run->machine, budget ? budget : UINT64_MAX);
+    run->status = halted ? NEANDER_HALTED : NEANDER_BUDGET;
+    run->has_result = halted && neander_result(&run->machine, &run->result);
+    return true;
+}
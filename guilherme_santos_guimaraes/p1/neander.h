@@ -0,0 +1,277 @@
+#ifndef NEANDER_H
+#define NEANDER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * libneander: compilação de LPN, montagem e execução de imagens Neander
+ * sobre buffers em memória, mais o cache de saídas. O compilador, o
+ * assembler e o executor de linha de comando são construídos sobre ela;
+ * o executor acrescenta seus motores threaded, JIT e de perfil.
+ *
+ * O estado de cada compilação, montagem ou execução fica no seu
+ * contexto (NeanderCompiler, NeanderAssembler, NeanderRun). O compilador
+ * guarda, por thread, um ponteiro _Thread_local para o contexto em uso
+ * durante a chamada: contextos distintos podem ser usados ao mesmo tempo
+ * em threads diferentes; um mesmo contexto não.
+ */
+
+#define MEM_SIZE 512
+#define HEADER_SIZE 4
+#define VAR_START 0x100
+
+// O código cabe entre o magic e os dados; cada instrução ocupa 2 palavras
+#define INSTRUCTION_LIMIT ((VAR_START - HEADER_SIZE) / 4)
+#define MEMORY_WORD_LIMIT (MEM_SIZE / 2)
+
+// Formato NDR v2: após o magic vem um cabeçalho versionado e uma tabela
+// de seções; o marcador 0xFF nunca é um opcode, o que distingue do v1
+#define NDR_V2_MARKER   0xFF
+#define NDR_VERSION     2
+#define NDR_V2_HEADER   16
+#define NDR_SECTION_LEN 8
+#define NO_ADDRESS      0xFFFF
+
+enum { SECTION_CODE = 1, SECTION_DATA = 2, SECTION_SYMBOLS = 3 };
+
+// OpCodes
+#define OP_NOP  0x00
+#define OP_STA  0x10
+#define OP_LDA  0x20
+#define OP_ADD  0x30
+#define OP_SUB  0x31
+#define OP_OR   0x40
+#define OP_AND  0x50
+#define OP_NOT  0x60
+#define OP_JMP  0x80
+#define OP_JMN  0x90
+#define OP_JMZ  0xA0
+#define OP_HLT  0xF0
+#define OP_INVALID 0xFF
+
+// Valores gravados no campo de tipo da seção de símbolos do v2
+typedef enum { SYM_DATA = 0, SYM_LABEL = 1 } SymbolKind;
+
+typedef struct {
+    size_t name;      // deslocamento em names
+    size_t name_len;
+    uint32_t hash;
+    int address;
+    SymbolKind kind;
+    bool defined;
+} NeanderSymbol;
+
+// Operando ainda sem endereço, resolvido em neander_finish
+typedef struct {
+    int at;           // byte do operando em memory
+    char* name;
+    int line;
+    bool branch;      // JMP/JMN/JMZ só aceitam rótulos
+} NeanderFixup;
+
+typedef struct {
+    uint8_t memory[MEM_SIZE];
+    int pc;
+    int code_end;
+    int var_ptr;
+
+    NeanderSymbol* symbols;
+    int symbol_count, symbol_capacity;
+    int* symbol_index;        // -1 = vazio
+    int index_capacity;       // potência de 2
+    char* names;
+    size_t names_len, names_capacity;
+
+    NeanderFixup* fixups;
+    int fixup_count, fixup_capacity;
+
+    char error[256];          // mensagem da última falha
+} NeanderAssembler;
+
+void neander_init(NeanderAssembler* a);
+void neander_free(NeanderAssembler* a);
+
+// OP_INVALID se o mnemônico não existe
+uint8_t neander_opcode(const char* mnemonic);
+bool neander_has_operand(uint8_t opcode);
+bool neander_is_branch(uint8_t opcode);
+
+// Operandos são palavras: o byte addr corresponde à palavra (addr - 4) / 2
+uint8_t neander_operand_word(int addr);
+
+const NeanderSymbol* neander_find_symbol(const NeanderAssembler* a, const char* name);
+const char* neander_symbol_name(const NeanderAssembler* a, const NeanderSymbol* sym);
+
+/*
+ * As funções abaixo devolvem false em caso de erro, com a mensagem em
+ * a->error; line (se maior que zero) entra na mensagem.
+ */
+bool neander_org(NeanderAssembler* a, int word, int line);
+// Um nome já declarado é ignorado, como no .DATA
+bool neander_define_data(NeanderAssembler* a, const char* name, int value, int line);
+bool neander_define_label(NeanderAssembler* a, const char* name, int line);
+// operand é NULL para NOP, NOT e HLT
+bool neander_emit(NeanderAssembler* a, uint8_t opcode, const char* operand, int line);
+// Garante o HLT final e faz o backpatch dos operandos pendentes
+bool neander_finish(NeanderAssembler* a, int line);
+
+// Monta um .asm inteiro (texto em memória, não precisa terminar em NUL).
+// Inicializa a; chame neander_free mesmo quando falhar
+bool neander_assemble(NeanderAssembler* a, const char* text, size_t len);
+
+// Imagem v2 num buffer alocado com malloc; o v1 é a própria memory (MEM_SIZE bytes)
+uint8_t* neander_image_v2(const NeanderAssembler* a, size_t* len);
+
+void neander_write_v1(const NeanderAssembler* a, FILE* out);
+void neander_write_v2(const NeanderAssembler* a, FILE* out);
+
+/*
+ * Execução de imagens v1 e v2. O executor usa o mesmo loader e o mesmo
+ * interpretador switch, e acrescenta seus outros motores e o watchdog.
+ */
+#define NEANDER_RUN_MEMORY (MEM_SIZE + 4)   // o operando 255 alcança o byte 514
+
+typedef struct {
+    uint8_t ac, pc;
+    bool z, n;
+    uint64_t steps;
+    int result_addr;      // endereço de RESULT (-1 em imagens v1)
+    uint8_t bytes[NEANDER_RUN_MEMORY];
+} NeanderMachine;
+
+typedef enum { NEANDER_LOAD_OK, NEANDER_LOAD_IO, NEANDER_LOAD_HEADER } NeanderLoadStatus;
+
+// Lê size bytes da imagem a partir de offset; false em erro de leitura
+typedef bool (*NeanderFetch)(void* source, uint8_t* dest, size_t size, size_t offset);
+
+// Carrega image[0..len) em m. Seções v2 além de len vêm de fetch;
+// sem fetch, uma seção fora do buffer invalida a imagem
+NeanderLoadStatus neander_load(NeanderMachine* m, const uint8_t* image, size_t len,
+                               NeanderFetch fetch, void* source);
+
+// Interpretador switch: roda a partir do estado atual até o HLT (true)
+// ou até steps chegar a limit (false); pode ser chamado de novo para continuar
+bool neander_step(NeanderMachine* m, uint64_t limit);
+
+// RESULT pelo endereço do v2; no v1, a primeira palavra igual ao acumulador
+bool neander_result(const NeanderMachine* m, uint8_t* value);
+
+typedef enum { NEANDER_HALTED, NEANDER_BUDGET } NeanderRunStatus;
+
+typedef struct {
+    NeanderMachine machine;
+    NeanderRunStatus status;
+    bool has_result;
+    uint8_t result;
+} NeanderRun;
+
+// Carrega e executa; budget limita as instruções (0 = sem limite).
+// false se a imagem é inválida
+bool neander_run(const uint8_t* image, size_t len, uint64_t budget, NeanderRun* run);
+
+/*
+ * Compilador LPN. O contexto guarda o último programa compilado, para
+ * gerar a listagem e a imagem, e reaproveita os buffers entre compilações.
+ */
+typedef struct NeanderCompiler NeanderCompiler;
+
+typedef struct {
+    bool optimize;    // peephole, simplificação e realocação de temporários (--no-opt)
+    bool propagate;   // propagação de constantes entre comandos (--no-propagate)
+    FILE* log;        // tokens, avisos e resumo da otimização; NULL = silencioso
+} NeanderCompileOptions;
+
+// options NULL: tudo ligado e sem log
+NeanderCompiler* neander_compiler_new(const NeanderCompileOptions* options);
+void neander_compiler_free(NeanderCompiler* c);
+
+// false em erro de sintaxe ou se o programa não cabe na memória
+// (INSTRUCTION_LIMIT, MEMORY_WORD_LIMIT), com a mensagem em neander_compiler_error
+bool neander_compile(NeanderCompiler* c, const char* source, size_t len);
+const char* neander_compiler_error(const NeanderCompiler* c);
+// Só a análise léxica; devolve o número de tokens, incluindo o fim de arquivo
+int neander_compiler_scan(NeanderCompiler* c, const char* source, size_t len);
+
+// Fases medidas por neander_compile, na ordem em que rodam
+typedef enum {
+    NEANDER_PHASE_SCAN,       // análise léxica
+    NEANDER_PHASE_PARSE,      // análise sintática
+    NEANDER_PHASE_CODEGEN,    // propagação de constantes e geração de código
+    NEANDER_PHASE_OPTIMIZE,   // peephole e realocação de temporários
+    NEANDER_PHASE_COUNT
+} NeanderPhase;
+
+typedef struct {
+    double milliseconds;
+    unsigned long heap_allocations;   // malloc, calloc e realloc
+    unsigned long arena_allocations;  // nós, comandos e nomes
+    size_t heap_bytes;                // bytes pedidos ao heap
+} NeanderPhaseStats;
+
+// Símbolos por categoria: total criado e quantos ocupam uma palavra na .DATA
+typedef struct {
+    int total, data;
+} NeanderSymbolCount;
+
+typedef struct {
+    NeanderPhaseStats phases[NEANDER_PHASE_COUNT];
+    int tokens;               // incluindo o fim de arquivo
+    int syntax_nodes;         // nós criados pelo parser
+    int commands;
+    NeanderSymbolCount user, constants, temporaries, builtins;
+    int instructions;         // de INSTRUCTION_LIMIT
+    int data_words;
+    int memory_words;         // 2 por instrução mais os dados, de MEMORY_WORD_LIMIT
+} NeanderCompileStats;
+
+// Números da última chamada a neander_compile (parciais se ela falhou)
+void neander_compiler_stats(NeanderCompiler* c, NeanderCompileStats* stats);
+
+void neander_compiler_write_listing(NeanderCompiler* c, FILE* out);
+// Monta o programa compilado em image (inicializada aqui; chame neander_free)
+bool neander_compiler_image(NeanderCompiler* c, NeanderAssembler* image);
+
+/*
+ * Cache de saídas em disco, endereçado pelo conteúdo (neander_cache.c).
+ * A chave é o SHA-256 de ferramenta + versão, opções e bytes da entrada;
+ * uma entrada guarda um arquivo por artefato ("asm", "bin", "log").
+ */
+#define NEANDER_CACHE_PATH 512
+
+typedef struct {
+    char dir[NEANDER_CACHE_PATH];
+    char key[65];                          // hex do SHA-256
+    char entry[NEANDER_CACHE_PATH + 72];   // <dir>/<2 hex>/<62 hex>
+    char staging[NEANDER_CACHE_PATH + 32]; // entrada em gravação
+    bool hit;
+    bool failed;
+} NeanderCache;
+
+typedef struct {
+    unsigned long long hits, misses, stores;
+} NeanderCacheStats;
+
+// $NEANDER_CACHE_DIR, ou .neander_cache no diretório atual
+const char* neander_cache_dir(void);
+// Cria o diretório se preciso; dir NULL usa neander_cache_dir()
+bool neander_cache_open(NeanderCache* c, const char* dir);
+// tool deve mudar junto com qualquer mudança que altere as saídas
+void neander_cache_key(NeanderCache* c, const char* tool, const char* settings, const void* input, size_t len);
+// Conta acerto ou falha nas estatísticas do diretório
+bool neander_cache_lookup(NeanderCache* c);
+// Artefato da entrada num buffer alocado com malloc; NULL se ausente
+uint8_t* neander_cache_load(NeanderCache* c, const char* name, size_t* len);
+
+// Gravação: begin, um put por artefato e commit, que publica a entrada inteira
+bool neander_cache_begin(NeanderCache* c);
+bool neander_cache_put(NeanderCache* c, const char* name, const void* data, size_t len);
+bool neander_cache_commit(NeanderCache* c);
+
+// Contadores acumulados de todas as execuções sobre o diretório
+bool neander_cache_stats(const char* dir, NeanderCacheStats* stats);
+void neander_cache_print_stats(const char* dir, FILE* out);
+
+#endif
@@ -0,0 +1,301 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+#include "neander.h"
+
+/*
+ * Cache de saídas endereçado pelo conteúdo. A chave é o SHA-256 de
+ * ferramenta + versão, opções e bytes da entrada; cada entrada é um
+ * diretório <dir>/<2 hex>/<62 hex>/ com um arquivo por artefato. A gravação
+ * monta a entrada num diretório temporário e a publica com rename, então
+ * processos concorrentes (CI com vários jobs) nunca leem uma entrada pela
+ * metade. As estatísticas acumuladas ficam em <dir>/stats, sob flock.
+ */
+
+// SHA-256 (FIPS 180-4)
+typedef struct {
+    uint32_t state[8];
+    uint8_t block[64];
+    size_t used;
+    uint64_t total;
+} Sha256;
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_init(Sha256* s) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(s->state, initial, sizeof(initial));
+    s->used = 0;
+    s->total = 0;
+}
+
+static void sha256_block(Sha256* s, const uint8_t* p) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++)
+        w[i] = (uint32_t)p[4*i] << 24 | (uint32_t)p[4*i+1] << 16 | (uint32_t)p[4*i+2] << 8 | p[4*i+3];
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROTR(w[i-15], 7) ^ ROTR(w[i-15], 18) ^ (w[i-15] >> 3);
+        uint32_t s1 = ROTR(w[i-2], 17) ^ ROTR(w[i-2], 19) ^ (w[i-2] >> 10);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+
+    uint32_t a = s->state[0], b = s->state[1], c = s->state[2], d = s->state[3];
+    uint32_t e = s->state[4], f = s->state[5], g = s->state[6], h = s->state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+        uint32_t t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    s->state[0] += a; s->state[1] += b; s->state[2] += c; s->state[3] += d;
+    s->state[4] += e; s->state[5] += f; s->state[6] += g; s->state[7] += h;
+}
+
+static void sha256_update(Sha256* s, const void* data, size_t len) {
+    const uint8_t* p = data;
+    s->total += len;
+    if (s->used > 0) {
+        size_t take = 64 - s->used < len ? 64 - s->used : len;
+        memcpy(s->block + s->used, p, take);
+        s->used += take;
+        p += take;
+        len -= take;
+        if (s->used < 64)
+            return;
+        sha256_block(s, s->block);
+        s->used = 0;
+    }
+    for (; len >= 64; p += 64, len -= 64)
+        sha256_block(s, p);
+    memcpy(s->block, p, len);
+    s->used = len;
+}
+
+static void sha256_final(Sha256* s, uint8_t digest[32]) {
+    uint64_t bits = s->total * 8;
+    uint8_t pad[72] = { 0x80 };
+    size_t pad_len = (s->used < 56 ? 56 : 120) - s->used;
+    for (int i = 0; i < 8; i++)
+        pad[pad_len + i] = (uint8_t)(bits >> (56 - 8*i));
+    sha256_update(s, pad, pad_len + 8);
+    for (int i = 0; i < 8; i++) {
+        digest[4*i]   = (uint8_t)(s->state[i] >> 24);
+        digest[4*i+1] = (uint8_t)(s->state[i] >> 16);
+        digest[4*i+2] = (uint8_t)(s->state[i] >> 8);
+        digest[4*i+3] = (uint8_t)s->state[i];
+    }
+}
+
+// Campos de tamanho prefixado, para que "ab"+"c" e "a"+"bc" deem chaves diferentes
+static void hash_field(Sha256* s, const void* data, size_t len) {
+    uint8_t size[8];
+    for (int i = 0; i < 8; i++)
+        size[i] = (uint8_t)((uint64_t)len >> (8*i));
+    sha256_update(s, size, sizeof(size));
+    sha256_update(s, data, len);
+}
+
+static bool make_dirs(char* path) {
+    for (char* p = path + 1; ; p++) {
+        if (*p != '/' && *p != '\0')
+            continue;
+        char saved = *p;
+        *p = '\0';
+        bool ok = mkdir(path, 0777) == 0 || errno == EEXIST;
+        *p = saved;
+        if (!ok)
+            return false;
+        if (saved == '\0')
+            return true;
+    }
+}
+
+// Entradas só contêm arquivos: um nível basta
+static void remove_entry(const char* path) {
+    DIR* dir = opendir(path);
+    if (dir) {
+        char file[NEANDER_CACHE_PATH + 336];
+        for (struct dirent* item; (item = readdir(dir)) != NULL; ) {
+            if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0)
+                continue;
+            snprintf(file, sizeof(file), "%s/%s", path, item->d_name);
+            unlink(file);
+        }
+        closedir(dir);
+    }
+    rmdir(path);
+}
+
+const char* neander_cache_dir(void) {
+    const char* dir = getenv("NEANDER_CACHE_DIR");
+    return dir && dir[0] ? dir : ".neander_cache";
+}
+
+bool neander_cache_open(NeanderCache* c, const char* dir) {
+    memset(c, 0, sizeof(*c));
+    if (!dir)
+        dir = neander_cache_dir();
+    if (strlen(dir) >= sizeof(c->dir))
+        return false;
+    strcpy(c->dir, dir);
+    return make_dirs(c->dir);
+}
+
+void neander_cache_key(NeanderCache* c, const char* tool, const char* settings, const void* input, size_t len) {
+    Sha256 s;
+    uint8_t digest[32];
+    sha256_init(&s);
+    hash_field(&s, tool, strlen(tool));
+    hash_field(&s, settings, strlen(settings));
+    hash_field(&s, input, len);
+    sha256_final(&s, digest);
+
+    for (int i = 0; i < 32; i++)
+        snprintf(c->key + 2*i, 3, "%02x", digest[i]);
+    snprintf(c->entry, sizeof(c->entry), "%s/%.2s/%s", c->dir, c->key, c->key + 2);
+    c->hit = false;
+}
+
+// Soma aos contadores de <dir>/stats; falhas aqui não afetam a compilação
+static void add_stats(const NeanderCache* c, int hits, int misses, int stores) {
+    char path[NEANDER_CACHE_PATH + 16];
+    snprintf(path, sizeof(path), "%s/stats", c->dir);
+    int fd = open(path, O_RDWR | O_CREAT, 0666);
+    if (fd < 0)
+        return;
+    FILE* file = fdopen(fd, "r+");
+    if (!file) {
+        close(fd);
+        return;
+    }
+    flock(fd, LOCK_EX);
+    NeanderCacheStats stats = { 0, 0, 0 };
+    if (fscanf(file, "acertos %llu falhas %llu gravacoes %llu",
+               &stats.hits, &stats.misses, &stats.stores) != 3)
+        stats = (NeanderCacheStats){ 0, 0, 0 };
+    stats.hits += hits;
+    stats.misses += misses;
+    stats.stores += stores;
+    rewind(file);
+    fprintf(file, "acertos %llu\nfalhas %llu\ngravacoes %llu\n", stats.hits, stats.misses, stats.stores);
+    fflush(file);
+    ftruncate(fd, ftell(file));
+    flock(fd, LOCK_UN);
+    fclose(file);
+}
+
+bool neander_cache_lookup(NeanderCache* c) {
+    struct stat info;
+    c->hit = stat(c->entry, &info) == 0 && S_ISDIR(info.st_mode);
+    add_stats(c, c->hit, !c->hit, 0);
+    return c->hit;
+}
+
+uint8_t* neander_cache_load(NeanderCache* c, const char* name, size_t* len) {
+    char path[sizeof(c->entry) + 16];
+    snprintf(path, sizeof(path), "%s/%s", c->entry, name);
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+
+    size_t capacity = 4096;
+    uint8_t* data = malloc(capacity);
+    *len = 0;
+    for (size_t got; data && (got = fread(data + *len, 1, capacity - *len, file)) > 0; ) {
+        *len += got;
+        if (*len == capacity) {
+            capacity *= 2;
+            uint8_t* bigger = realloc(data, capacity);
+            if (!bigger) free(data);
+            data = bigger;
+        }
+    }
+    if (data && ferror(file)) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+bool neander_cache_begin(NeanderCache* c) {
+    // Único por processo e por thread: contextos podem gravar ao mesmo tempo
+    static atomic_uint sequence;
+    snprintf(c->staging, sizeof(c->staging), "%s/tmp-%ld-%u", c->dir, (long)getpid(), atomic_fetch_add(&sequence, 1));
+    c->failed = mkdir(c->staging, 0777) != 0;
+    return !c->failed;
+}
+
+bool neander_cache_put(NeanderCache* c, const char* name, const void* data, size_t len) {
+    if (c->failed)
+        return false;
+    char path[sizeof(c->entry) + 16];
+    snprintf(path, sizeof(path), "%s/%s", c->staging, name);
+    FILE* file = fopen(path, "wb");
+    bool ok = file && fwrite(data, 1, len, file) == len;
+    if (file && fclose(file) != 0)
+        ok = false;
+    c->failed = !ok;
+    return ok;
+}
+
+bool neander_cache_commit(NeanderCache* c) {
+    char bucket[NEANDER_CACHE_PATH + 4];
+    snprintf(bucket, sizeof(bucket), "%s/%.2s", c->dir, c->key);
+    bool ok = !c->failed && (mkdir(bucket, 0777) == 0 || errno == EEXIST);
+    if (ok && rename(c->staging, c->entry) != 0) {
+        // Outro processo publicou a mesma chave primeiro: o conteúdo é o mesmo.
+        // Se a entrada existente é a que falhou na leitura, troca pela nova
+        ok = (errno == EEXIST || errno == ENOTEMPTY) && !c->hit;
+        if (c->hit) {
+            remove_entry(c->entry);
+            ok = rename(c->staging, c->entry) == 0;
+        }
+    }
+    remove_entry(c->staging);  // já não existe se o rename deu certo
+    if (ok)
+        add_stats(c, 0, 0, 1);
+    return ok;
+}
+
+bool neander_cache_stats(const char* dir, NeanderCacheStats* stats) {
+    char path[NEANDER_CACHE_PATH + 16];
+    snprintf(path, sizeof(path), "%s/stats", dir ? dir : neander_cache_dir());
+    *stats = (NeanderCacheStats){ 0, 0, 0 };
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return false;
+    bool ok = fscanf(file, "acertos %llu falhas %llu gravacoes %llu",
+                     &stats->hits, &stats->misses, &stats->stores) == 3;
+    fclose(file);
+    return ok;
+}
+
+void neander_cache_print_stats(const char* dir, FILE* out) {
+    NeanderCacheStats stats;
+    neander_cache_stats(dir, &stats);
+    unsigned long long lookups = stats.hits + stats.misses;
+    fprintf(out, "Cache %s: %llu acertos, %llu falhas (%.1f%% de acerto), %llu entradas gravadas\n",
+            dir ? dir : neander_cache_dir(), stats.hits, stats.misses,
+            lookups ? 100.0 * stats.hits / lookups : 0.0, stats.stores);
+}
@@ -0,0 +1,2321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>  // For boolean support
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <time.h>
+
+#include "neander.h"
+
+/*========================================================================
+  Compiler State
+
+  Everything a compilation builds lives in a NeanderCompiler, so separate
+  compilers can run at the same time on different threads. The public
+  entry points point the thread's `compiler` at the context they were
+  given, and the passes below read and write their state through it.
+========================================================================*/
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t size;
+    max_align_t data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock* head;
+} Arena;
+
+typedef enum {
+    TK_START,
+    TK_BEGIN,
+    TK_FINISH,
+    TK_RESULT,
+    TK_NAME,
+    TK_NUMBER,
+    TK_ASSIGN,
+    TK_ADD,
+    TK_SUBTRACT,
+    TK_MULTIPLY,
+    TK_DIVIDE,
+    TK_MODULO,
+    TK_OPEN_BRACKET,
+    TK_CLOSE_BRACKET,
+    TK_DELIMITER,
+    TK_END_OF_FILE,
+    TK_INVALID
+} LexicalType;
+
+// Tokens are views into the source (or static text), not NUL-terminated
+typedef struct {
+    LexicalType category;
+    int length;
+    const char* text;
+} LexicalToken;
+
+typedef enum { NODE_LITERAL, NODE_IDENTIFIER, NODE_OPERATION } NodeCategory;
+
+typedef struct SyntaxNode {
+    NodeCategory category;
+    union {
+        int value;              // for numbers
+        const char* identifier; // for variables (interned)
+        struct {
+            char operator;     // '+', '-', '*', '/', '%'
+            struct SyntaxNode *leftChild;
+            struct SyntaxNode *rightChild;
+        } operation;
+    };
+    int useCount;               // parents in the expression DAG
+    const char* valueName;      // TEMP_ holding the value once computed (shared nodes)
+    int need;                   // Sethi-Ullman number, -1 until computed
+} SyntaxNode;
+
+typedef struct Command {
+    const char* variable;   // interned
+    SyntaxNode* expression;
+    struct Command* next;
+} Command;
+
+/* Program structure representation */
+typedef struct {
+    const char* title;
+    Command* commands;
+    SyntaxNode* output;
+} CompilationUnit;
+
+typedef struct {
+    const char* variable;   // interned
+    int value;              // -1 while unknown
+    bool live;
+} VariableState;
+
+#define MAX_NAME_LENGTH 63     // longest operand an AsmItem holds
+
+typedef enum { SYMBOL_USER, SYMBOL_CONSTANT, SYMBOL_TEMPORARY, SYMBOL_BUILTIN } SymbolCategory;
+
+typedef struct {
+    const char* identifier;     // interned, at most MAX_NAME_LENGTH characters
+    SymbolCategory category;
+    int data;
+    bool initialized;
+    bool referenced;            // used by the final code (set by markReferences)
+} Symbol;
+
+typedef struct {
+    int value;
+    int symbol;                 // -1 = empty
+} ConstantSlot;
+
+typedef enum { ITEM_INSTRUCTION, ITEM_LABEL, ITEM_COMMENT } ItemKind;
+
+typedef struct {
+    ItemKind kind;
+    char mnemonic[8];
+    char operand[MAX_NAME_LENGTH + 1];   // operand, label name or comment text
+    bool removed;
+} AsmItem;
+
+struct NeanderCompiler {
+    Arena arena;                    // nodes, commands and interned names
+    const char** internSlots;
+    size_t internCapacity;          // power of 2
+    size_t internCount;
+    
+    char* inputCode;                // copy of the source followed by INPUT_PADDING zero bytes
+    size_t inputCapacity;
+    LexicalToken* tokenArray;
+    int tokenTotal;
+    int tokenCapacity;
+    int currentIndex;
+    
+    Command* commandList;
+    Command* lastCommand;
+    CompilationUnit program;
+    
+    SyntaxNode** valueSlots;
+    size_t valueCapacity;           // power of 2
+    size_t valueCount;
+    
+    VariableState* variableStates;
+    int variableStateCount;
+    int variableStateCapacity;
+    int removedAssignments;
+    
+    Symbol* symbols;                // data words in order of creation
+    int symbolCount;
+    int symbolCapacity;
+    int* symbolIndex;               // by name, -1 = empty
+    size_t symbolIndexCapacity;     // power of 2
+    ConstantSlot* constantSlots;    // CONST_ symbols by value
+    size_t constantCapacity;        // power of 2
+    size_t constantCount;
+    int tempVarCount;
+    int mulLabelCount;
+    int divLabelCount;
+    
+    AsmItem* asmItems;
+    int itemCount;
+    int itemCapacity;
+    
+    int tempsBeforeAllocation;
+    int tempSlotCount;
+    int peakLiveTemps;
+    int* intervalStart;
+    int* intervalEnd;
+    
+    NeanderCompileStats stats;      // filled in by neander_compile
+    unsigned long heapAllocations;  // running totals, split per phase in stats
+    unsigned long arenaAllocations;
+    size_t heapBytes;
+    int nodeCount;
+    
+    bool optimizeEnabled;
+    bool propagateEnabled;          // --no-propagate keeps each statement's code
+    FILE* log;                      // tokens, warnings and the summary; NULL = silent
+    jmp_buf failure;                // where compileError returns to
+    char error[256];
+};
+
+static _Thread_local NeanderCompiler* compiler;
+
+static void logMessage(const char* format, ...) {
+    if (!compiler->log)
+        return;
+    va_list args;
+    va_start(args, format);
+    vfprintf(compiler->log, format, args);
+    va_end(args);
+}
+
+// Records the message and abandons the compilation in progress
+static _Noreturn void compileError(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(compiler->error, sizeof(compiler->error), format, args);
+    va_end(args);
+    longjmp(compiler->failure, 1);
+}
+
+// Heap calls of the passes go through these so the statistics can count them
+static void* countedMalloc(size_t size) {
+    compiler->heapAllocations++;
+    compiler->heapBytes += size;
+    return malloc(size);
+}
+
+static void* countedCalloc(size_t count, size_t size) {
+    compiler->heapAllocations++;
+    compiler->heapBytes += count * size;
+    return calloc(count, size);
+}
+
+static void* countedRealloc(void* ptr, size_t size) {
+    compiler->heapAllocations++;
+    compiler->heapBytes += size;
+    return realloc(ptr, size);
+}
+
+// Phase statistics are the difference of the running totals across the phase
+typedef struct {
+    struct timespec start;
+    unsigned long heapAllocations;
+    unsigned long arenaAllocations;
+    size_t heapBytes;
+} PhaseMark;
+
+static PhaseMark startPhase() {
+    PhaseMark mark = { .heapAllocations = compiler->heapAllocations,
+                       .arenaAllocations = compiler->arenaAllocations,
+                       .heapBytes = compiler->heapBytes };
+    clock_gettime(CLOCK_MONOTONIC, &mark.start);
+    return mark;
+}
+
+static void finishPhase(NeanderPhase phase, const PhaseMark* mark) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    NeanderPhaseStats* stats = &compiler->stats.phases[phase];
+    stats->milliseconds = (end.tv_sec - mark->start.tv_sec) * 1e3 + (end.tv_nsec - mark->start.tv_nsec) / 1e6;
+    stats->heap_allocations = compiler->heapAllocations - mark->heapAllocations;
+    stats->arena_allocations = compiler->arenaAllocations - mark->arenaAllocations;
+    stats->heap_bytes = compiler->heapBytes - mark->heapBytes;
+}
+
+/*========================================================================
+  Memory Arena
+
+  Syntax nodes, commands and interned names are bump-allocated from large
+  blocks and released together when compilation ends.
+========================================================================*/
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+static void* arenaAlloc(Arena* arena, size_t size) {
+    size = (size + sizeof(max_align_t) - 1) & ~(sizeof(max_align_t) - 1);
+    ArenaBlock* block = arena->head;
+    
+    if (!block || block->used + size > block->size) {
+        size_t capacity = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = countedMalloc(sizeof(ArenaBlock) + capacity);
+        if (!block) {
+            perror("Erro na alocação de memória");
+            exit(1);
+        }
+        block->next = arena->head;
+        block->used = 0;
+        block->size = capacity;
+        arena->head = block;
+    }
+    
+    void* ptr = (char*)block->data + block->used;
+    block->used += size;
+    compiler->arenaAllocations++;
+    return ptr;
+}
+
+static void arenaRelease(Arena* arena) {
+    while (arena->head) {
+        ArenaBlock* next = arena->head->next;
+        free(arena->head);
+        arena->head = next;
+    }
+}
+
+/*========================================================================
+  Name Interning
+
+  Every distinct name is copied once into the arena; equal names share
+  the same NUL-terminated string.
+========================================================================*/
+static uint32_t hashText(const char* text, int length) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++)
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    return hash;
+}
+
+static const char* internName(const char* text, int length) {
+    if (2 * (compiler->internCount + 1) > compiler->internCapacity) {
+        size_t oldCapacity = compiler->internCapacity;
+        const char** oldSlots = compiler->internSlots;
+        compiler->internCapacity = compiler->internCapacity ? compiler->internCapacity * 2 : 256;
+        compiler->internSlots = countedCalloc(compiler->internCapacity, sizeof(const char*));
+        if (!compiler->internSlots) {
+            perror("Erro na alocação de memória");
+            exit(1);
+        }
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (!oldSlots[i]) continue;
+            size_t slot = hashText(oldSlots[i], strlen(oldSlots[i])) & (compiler->internCapacity - 1);
+            while (compiler->internSlots[slot])
+                slot = (slot + 1) & (compiler->internCapacity - 1);
+            compiler->internSlots[slot] = oldSlots[i];
+        }
+        free(oldSlots);
+    }
+    
+    size_t slot = hashText(text, length) & (compiler->internCapacity - 1);
+    while (compiler->internSlots[slot]) {
+        if (strncmp(compiler->internSlots[slot], text, length) == 0 && compiler->internSlots[slot][length] == '\0')
+            return compiler->internSlots[slot];
+        slot = (slot + 1) & (compiler->internCapacity - 1);
+    }
+    
+    char* name = arenaAlloc(&compiler->arena, length + 1);
+    memcpy(name, text, length);
+    name[length] = '\0';
+    compiler->internSlots[slot] = name;
+    compiler->internCount++;
+    return name;
+}
+
+/*========================================================================
+  Lexical Section - Token Processing
+
+  One linear pass driven by a character-class table. Blanks are skipped a
+  machine word at a time, identifiers are scanned first and only then
+  checked against the keywords through a perfect hash, and every other
+  token is a single character looked up in a table. The source copy is
+  padded with zero bytes, so the word loads never read past the buffer.
+========================================================================*/
+#define INPUT_PADDING 8
+
+enum {
+    CHAR_BLANK  = 1,    // ' ', '\t', '\r', '\n'
+    CHAR_ALPHA  = 2,
+    CHAR_DIGIT  = 4,
+    CHAR_NAME   = 8,    // continues an identifier: letters, digits, '_'
+    CHAR_SINGLE = 16,   // one-character token
+    CHAR_QUOTE  = 32
+};
+
+static const uint8_t charClass[256] = {
+    [' '] = CHAR_BLANK, ['\t'] = CHAR_BLANK, ['\r'] = CHAR_BLANK, ['\n'] = CHAR_BLANK,
+    ['A' ... 'Z'] = CHAR_ALPHA | CHAR_NAME,
+    ['a' ... 'z'] = CHAR_ALPHA | CHAR_NAME,
+    ['0' ... '9'] = CHAR_DIGIT | CHAR_NAME,
+    ['_'] = CHAR_NAME,
+    ['='] = CHAR_SINGLE, ['+'] = CHAR_SINGLE, ['-'] = CHAR_SINGLE, ['*'] = CHAR_SINGLE,
+    ['/'] = CHAR_SINGLE, ['%'] = CHAR_SINGLE, ['('] = CHAR_SINGLE, [')'] = CHAR_SINGLE,
+    [':'] = CHAR_SINGLE,
+    ['"'] = CHAR_QUOTE
+};
+
+static const LexicalType singleToken[256] = {
+    ['='] = TK_ASSIGN, ['+'] = TK_ADD, ['-'] = TK_SUBTRACT, ['*'] = TK_MULTIPLY,
+    ['/'] = TK_DIVIDE, ['%'] = TK_MODULO, ['('] = TK_OPEN_BRACKET, [')'] = TK_CLOSE_BRACKET,
+    [':'] = TK_DELIMITER
+};
+
+// (length + first letter) & 7 is distinct for the four keywords
+typedef struct {
+    const char* text;
+    int length;
+    LexicalType category;
+} Keyword;
+
+static const Keyword keywords[8] = {
+    [(8 + 'P') & 7] = { "PROGRAMA", 8, TK_START },
+    [(6 + 'I') & 7] = { "INICIO", 6, TK_BEGIN },
+    [(3 + 'F') & 7] = { "FIM", 3, TK_FINISH },
+    [(3 + 'R') & 7] = { "RES", 3, TK_RESULT }
+};
+
+static LexicalType identifierCategory(const char* text, int length) {
+    const Keyword* keyword = &keywords[(length + text[0]) & 7];
+    if (keyword->length == length && memcmp(keyword->text, text, length) == 0)
+        return keyword->category;
+    return TK_NAME;
+}
+
+// High bit set in every byte of word equal to c (exact, no carries between bytes)
+static uint64_t bytesEqual(uint64_t word, char c) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    uint64_t x = word ^ (0x0101010101010101ULL * (uint8_t)c);
+    return ~(((x & low7) + low7) | x | low7);
+}
+
+static size_t skipBlanks(const char* input, size_t position) {
+    for (;;) {
+        uint64_t word;
+        memcpy(&word, input + position, sizeof(word));
+        uint64_t blank = bytesEqual(word, ' ') | bytesEqual(word, '\t') |
+                         bytesEqual(word, '\n') | bytesEqual(word, '\r');
+        uint64_t other = ~blank & 0x8080808080808080ULL;
+        if (other) {
+            // the lowest byte in memory is the least significant one on little-endian
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return position + __builtin_ctzll(other) / 8;
+#else
+            return position + __builtin_clzll(other) / 8;
+#endif
+        }
+        position += sizeof(word);
+    }
+}
+
+static void insertToken(LexicalType category, const char *text, int length) {
+    if (compiler->tokenTotal == compiler->tokenCapacity) {
+        compiler->tokenCapacity = compiler->tokenCapacity ? compiler->tokenCapacity * 2 : 1024;
+        compiler->tokenArray = countedRealloc(compiler->tokenArray, compiler->tokenCapacity * sizeof(LexicalToken));
+        if (!compiler->tokenArray) {
+            perror("Erro na alocação de memória");
+            exit(1);
+        }
+    }
+    LexicalToken* token = &compiler->tokenArray[compiler->tokenTotal++];
+    token->category = category;
+    token->length = length;
+    token->text = text;
+}
+
+static void scanTokens() {
+    compiler->tokenTotal = 0;
+    compiler->currentIndex = 0;  // Reset parsing index
+    const char* input = compiler->inputCode;
+    size_t position = 0;
+    
+    for (;;) {
+        position = skipBlanks(input, position);
+        unsigned char c = input[position];
+        if (c == '\0')
+            break;
+        
+        uint8_t class = charClass[c];
+        size_t start = position++;
+        if (class & CHAR_ALPHA) {
+            while (charClass[(unsigned char)input[position]] & CHAR_NAME)
+                position++;
+            int length = position - start;
+            insertToken(identifierCategory(&input[start], length), &input[start], length);
+        }
+        else if (class & CHAR_DIGIT) {
+            while (charClass[(unsigned char)input[position]] & CHAR_DIGIT)
+                position++;
+            insertToken(TK_NUMBER, &input[start], position - start);
+        }
+        else if (class & CHAR_SINGLE) {
+            insertToken(singleToken[c], &input[start], 1);
+        }
+        else if (class & CHAR_QUOTE) {
+            // Quoted string (program name), without the quotes
+            const char* end = strchr(&input[position], '"');
+            size_t stop = end ? (size_t)(end - input) : position + strlen(&input[position]);
+            insertToken(TK_NAME, &input[position], stop - position);
+            position = end ? stop + 1 : stop;
+        }
+        // anything else is skipped
+    }
+    
+    insertToken(TK_END_OF_FILE, "EOF", 3);
+
+    if (compiler->log)
+        for (int i = 0; i < compiler->tokenTotal; i++)
+            logMessage("Token[%d]:  Text='%.*s'\n", i, compiler->tokenArray[i].length, compiler->tokenArray[i].text);
+}
+
+static LexicalToken* peekNextToken() {
+    if (compiler->currentIndex < compiler->tokenTotal)
+        return &compiler->tokenArray[compiler->currentIndex];
+    return NULL;
+}
+
+static LexicalToken* consumeToken() {
+    if (compiler->currentIndex < compiler->tokenTotal)
+        return &compiler->tokenArray[compiler->currentIndex++];
+    return NULL;
+}
+
+/*========================================================================
+  Abstract Syntax Tree (AST) Construction
+========================================================================*/
+static SyntaxNode* createLiteralNode(int value) {
+    SyntaxNode* node = arenaAlloc(&compiler->arena, sizeof(SyntaxNode));
+    compiler->nodeCount++;
+    node->useCount = 0;
+    node->valueName = NULL;
+    node->need = -1;
+    node->category = NODE_LITERAL;
+    node->value = value;
+    return node;
+}
+
+static SyntaxNode* createIdentifierNode(const LexicalToken* token) {
+    SyntaxNode* node = arenaAlloc(&compiler->arena, sizeof(SyntaxNode));
+    compiler->nodeCount++;
+    node->useCount = 0;
+    node->valueName = NULL;
+    node->need = -1;
+    node->category = NODE_IDENTIFIER;
+    node->identifier = internName(token->text, token->length);
+    return node;
+}
+
+static SyntaxNode* createOperationNode(char operator, SyntaxNode* leftChild, SyntaxNode* rightChild) {
+    SyntaxNode* node = arenaAlloc(&compiler->arena, sizeof(SyntaxNode));
+    compiler->nodeCount++;
+    node->useCount = 0;
+    node->valueName = NULL;
+    node->need = -1;
+    node->category = NODE_OPERATION;
+    node->operation.operator = operator;
+    node->operation.leftChild = leftChild;
+    node->operation.rightChild = rightChild;
+    return node;
+}
+
+/* Recursive parsing functions for expressions */
+static SyntaxNode* parseExpression();
+static SyntaxNode* parseTerm();
+static SyntaxNode* parseFactor();
+
+static SyntaxNode* parseExpression() {
+    SyntaxNode* node = parseTerm();
+    LexicalToken* token;
+    
+    while ((token = peekNextToken()) && (token->category == TK_ADD || token->category == TK_SUBTRACT)) {
+        token = consumeToken(); // consume the operator
+        SyntaxNode* rightNode = parseTerm();
+        node = createOperationNode(token->text[0], node, rightNode);
+    }
+    return node;
+}
+
+static SyntaxNode* parseTerm() {
+    SyntaxNode* node = parseFactor();
+    LexicalToken* token;
+    
+    while ((token = peekNextToken()) && (token->category == TK_MULTIPLY || token->category == TK_DIVIDE ||
+                                     token->category == TK_MODULO)) {
+        token = consumeToken(); // consume the operator
+        SyntaxNode* rightNode = parseFactor();
+        node = createOperationNode(token->text[0], node, rightNode);
+    }
+    return node;
+}
+
+static SyntaxNode* parseFactor() {
+    LexicalToken* token = peekNextToken();
+    if (!token)
+        compileError("Erro: Esperado expressão (consultar gramatica.pdf)");
+    
+    if (token->category == TK_OPEN_BRACKET) {
+        consumeToken(); // consume '('
+        SyntaxNode* node = parseExpression();
+        token = consumeToken();
+        if (!token || token->category != TK_CLOSE_BRACKET)
+            compileError("Erro: Esperado ')' para fechar a expressão (consultar gramatica.pdf)");
+        return node;
+    }
+    
+    if (token->category == TK_NUMBER) {
+        token = consumeToken();
+        return createLiteralNode(atoi(token->text));
+    }
+    
+    if (token->category == TK_NAME) {
+        token = consumeToken();
+        return createIdentifierNode(token);
+    }
+    
+    compileError("Erro: Esperado expressão (consultar gramatica.pdf)");
+}
+
+/*========================================================================
+  Statement Representation
+========================================================================*/
+static void parseAssignmentStmt() {
+    LexicalToken* token = consumeToken(); // expect identifier
+    if (!token || token->category != TK_NAME) {
+        logMessage("Warning: Esperado identificador\n");
+        return;
+    }
+    
+    const char* varName = internName(token->text, token->length);
+    
+    LexicalToken* equals = consumeToken(); // expect '='
+    if (!equals || equals->category != TK_ASSIGN) {
+        logMessage("Esperado '='\n");
+        return;
+    }
+    
+    SyntaxNode* expr = parseExpression();
+    
+    Command* cmd = arenaAlloc(&compiler->arena, sizeof(Command));
+    cmd->variable = varName;
+    cmd->expression = expr;
+    cmd->next = NULL;
+    
+    if (compiler->commandList == NULL) {
+        compiler->commandList = cmd;
+        compiler->lastCommand = cmd;
+    } else {
+        compiler->lastCommand->next = cmd;
+        compiler->lastCommand = cmd;
+    }
+    
+}
+
+/*========================================================================
+  Program Parsing (according to grammar)
+  
+  Format:
+    PROGRAMA "Name" :
+    INICIO
+      <assignments>
+      RES = <expression>
+    FIM
+========================================================================*/
+static void parseProgram() {
+    LexicalToken* token = consumeToken(); // Should be PROGRAMA
+    if (!token || token->category != TK_START) { 
+        compileError("Erro: Esperado PROGRAMA no cabeçalho (consultar gramatica.pdf)\n");
+    }
+    
+    token = consumeToken(); // Program name (in quotes)
+    if (!token || token->category != TK_NAME) { 
+        compileError("Erro: Esperado NOME DO PROGRAMA no cabeçalho (consultar gramatica.pdf)\n");
+    }
+    compiler->program.title = internName(token->text, token->length);
+    
+    token = consumeToken(); // Should be ":"
+    if (!token || token->category != TK_DELIMITER) { 
+        compileError("Erro: Esperado ':' após o nome do programa (consultar gramatica.pdf)");
+    }
+    
+    token = consumeToken(); // Should be INICIO
+    if (!token || token->category != TK_BEGIN) { 
+        compileError("Erro: Esperado INICIO no código (consultar gramatica.pdf)\n");
+    }
+    
+    // Process assignments until we find RES
+    while (1) {
+        token = peekNextToken();
+        if (!token) break;
+        if (token->category == TK_RESULT)
+            break;
+        parseAssignmentStmt();
+    }
+    
+    token = consumeToken(); // Should be RES
+    if (!token || token->category != TK_RESULT) { 
+        compileError("Erro: Esperado RES para armazenar o retorno do programa (consultar gramatica.pdf)\n");
+    }
+    
+    token = consumeToken(); // Should be '='
+    if (!token || token->category != TK_ASSIGN) { 
+        compileError("Erro: Esperado '=' após RES (consultar gramatica.pdf)\n");
+    }
+    
+    compiler->program.output = parseExpression();
+    
+    token = consumeToken(); // Should be FIM
+    if (!token || token->category != TK_FINISH) { 
+        compileError("Erro: Esperado FIM para finalizar o programa (consultar gramatica.pdf)\n");
+    }
+}
+
+/*========================================================================
+  Expression Simplification
+
+  Each expression is rebuilt bottom-up through a hash table of nodes
+  (value numbering): structurally equal subtrees map to the same node, so
+  the tree becomes a DAG and a repeated subexpression is generated once.
+  While rebuilding, operations on literals are folded with the machine's
+  8-bit arithmetic, algebraic identities are applied and constant offsets
+  are merged, so (a + 2) + 3 becomes a + 5.
+
+  Variables cannot change inside an expression, but they can between
+  statements, so the table is cleared before each expression.
+========================================================================*/
+static bool isCommutative(char operator) {
+    return operator == '+' || operator == '*';
+}
+
+static uint32_t hashNode(const SyntaxNode* node) {
+    if (node->category == NODE_LITERAL)
+        return (uint32_t)node->value * 2654435761u;
+    if (node->category == NODE_IDENTIFIER)
+        return (uint32_t)((uintptr_t)node->identifier >> 3) * 2654435761u;
+    
+    uintptr_t left = (uintptr_t)node->operation.leftChild;
+    uintptr_t right = (uintptr_t)node->operation.rightChild;
+    if (isCommutative(node->operation.operator) && left > right) {
+        uintptr_t swap = left;
+        left = right;
+        right = swap;
+    }
+    uint32_t hash = hashText(&node->operation.operator, 1);
+    hash = (hash ^ (uint32_t)(left >> 3)) * 16777619u;
+    hash = (hash ^ (uint32_t)(right >> 3)) * 16777619u;
+    return hash;
+}
+
+// Children are already unique, so comparing them by pointer is enough
+static bool sameNode(const SyntaxNode* a, const SyntaxNode* b) {
+    if (a->category != b->category)
+        return false;
+    if (a->category == NODE_LITERAL)
+        return a->value == b->value;
+    if (a->category == NODE_IDENTIFIER)
+        return a->identifier == b->identifier;
+    if (a->operation.operator != b->operation.operator)
+        return false;
+    if (a->operation.leftChild == b->operation.leftChild && a->operation.rightChild == b->operation.rightChild)
+        return true;
+    return isCommutative(a->operation.operator) &&
+           a->operation.leftChild == b->operation.rightChild &&
+           a->operation.rightChild == b->operation.leftChild;
+}
+
+static SyntaxNode* uniqueNode(const SyntaxNode* key) {
+    if (2 * (compiler->valueCount + 1) > compiler->valueCapacity) {
+        size_t oldCapacity = compiler->valueCapacity;
+        SyntaxNode** oldSlots = compiler->valueSlots;
+        compiler->valueCapacity = compiler->valueCapacity ? compiler->valueCapacity * 2 : 256;
+        compiler->valueSlots = countedCalloc(compiler->valueCapacity, sizeof(SyntaxNode*));
+        if (!compiler->valueSlots) {
+            perror("Erro na alocação de memória");
+            exit(1);
+        }
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (!oldSlots[i]) continue;
+            size_t slot = hashNode(oldSlots[i]) & (compiler->valueCapacity - 1);
+            while (compiler->valueSlots[slot])
+                slot = (slot + 1) & (compiler->valueCapacity - 1);
+            compiler->valueSlots[slot] = oldSlots[i];
+        }
+        free(oldSlots);
+    }
+    
+    size_t slot = hashNode(key) & (compiler->valueCapacity - 1);
+    while (compiler->valueSlots[slot]) {
+        if (sameNode(compiler->valueSlots[slot], key))
+            return compiler->valueSlots[slot];
+        slot = (slot + 1) & (compiler->valueCapacity - 1);
+    }
+    
+    SyntaxNode* node = arenaAlloc(&compiler->arena, sizeof(SyntaxNode));
+    *node = *key;
+    node->useCount = 0;
+    node->valueName = NULL;
+    node->need = -1;
+    compiler->valueSlots[slot] = node;
+    compiler->valueCount++;
+    return node;
+}
+
+static SyntaxNode* makeLiteral(int value) {
+    SyntaxNode key = { .category = NODE_LITERAL, .value = value & 0xFF };
+    return uniqueNode(&key);
+}
+
+static SyntaxNode* makeOperation(char operator, SyntaxNode* leftChild, SyntaxNode* rightChild) {
+    SyntaxNode key = { .category = NODE_OPERATION };
+    key.operation.operator = operator;
+    key.operation.leftChild = leftChild;
+    key.operation.rightChild = rightChild;
+    return uniqueNode(&key);
+}
+
+// Same results as the generated code: x / 0 = 0 and x % 0 = x
+static int evaluateOperation(char operator, int left, int right) {
+    switch (operator) {
+        case '+': return (left + right) & 0xFF;
+        case '-': return (left - right) & 0xFF;
+        case '*': return (left * right) & 0xFF;
+        case '/': return right ? left / right : 0;
+        case '%': return right ? left % right : left;
+    }
+    return 0;
+}
+
+// Splits x + k, k + x and x - k into base x and offset +-k
+static bool splitOffset(SyntaxNode* node, SyntaxNode** base, int* offset) {
+    if (node->category != NODE_OPERATION)
+        return false;
+    
+    SyntaxNode* left = node->operation.leftChild;
+    SyntaxNode* right = node->operation.rightChild;
+    if (node->operation.operator == '+' && right->category == NODE_LITERAL) {
+        *base = left;
+        *offset = right->value;
+    } else if (node->operation.operator == '+' && left->category == NODE_LITERAL) {
+        *base = right;
+        *offset = left->value;
+    } else if (node->operation.operator == '-' && right->category == NODE_LITERAL) {
+        *base = left;
+        *offset = -right->value;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static SyntaxNode* makeOffset(SyntaxNode* base, int offset) {
+    offset &= 0xFF;
+    if (offset == 0)
+        return base;
+    if (offset > 128)
+        return makeOperation('-', base, makeLiteral(256 - offset));
+    return makeOperation('+', base, makeLiteral(offset));
+}
+
+static SyntaxNode* simplifyOperation(char operator, SyntaxNode* left, SyntaxNode* right) {
+    int a = left->category == NODE_LITERAL ? left->value : -1;
+    int b = right->category == NODE_LITERAL ? right->value : -1;
+    SyntaxNode* base;
+    int offset;
+    
+    if (a >= 0 && b >= 0)
+        return makeLiteral(evaluateOperation(operator, a, b));
+    
+    switch (operator) {
+        case '+':
+            if (a == 0) return right;
+            if (b == 0) return left;
+            if (b >= 0 && splitOffset(left, &base, &offset))
+                return makeOffset(base, offset + b);
+            if (a >= 0 && splitOffset(right, &base, &offset))
+                return makeOffset(base, offset + a);
+            break;
+        case '-':
+            if (b == 0) return left;
+            if (left == right) return makeLiteral(0);
+            if (b >= 0 && splitOffset(left, &base, &offset))
+                return makeOffset(base, offset - b);
+            if (a >= 0 && splitOffset(right, &base, &offset))
+                return makeOperation('-', makeLiteral(a - offset), base);
+            break;
+        case '*':
+            if (a == 0 || b == 0) return makeLiteral(0);
+            if (a == 1) return right;
+            if (b == 1) return left;
+            break;
+        case '/':
+        case '%':
+            if (b == 0) {
+                logMessage("Erro: Divisão por 0 detectada\n");
+                return operator == '/' ? makeLiteral(0) : left;
+            }
+            if (operator == '/' && b == 1) return left;
+            if (operator == '%' && (b == 1 || left == right)) return makeLiteral(0);
+            if (a == 0) return makeLiteral(0);
+            break;
+    }
+    return makeOperation(operator, left, right);
+}
+
+static int constantValue(const char* identifier);
+
+static SyntaxNode* simplifyExpression(SyntaxNode* node) {
+    if (!node)
+        return NULL;
+    if (node->category == NODE_LITERAL)
+        return makeLiteral(node->value);
+    if (node->category == NODE_IDENTIFIER) {
+        int value = constantValue(node->identifier);
+        return value >= 0 ? makeLiteral(value) : uniqueNode(node);
+    }
+    
+    SyntaxNode* left = simplifyExpression(node->operation.leftChild);
+    SyntaxNode* right = simplifyExpression(node->operation.rightChild);
+    if (!left || !right)
+        return makeOperation(node->operation.operator, left, right);
+    return simplifyOperation(node->operation.operator, left, right);
+}
+
+static void countUses(SyntaxNode* node) {
+    if (!node || node->useCount++ > 0)
+        return;
+    if (node->category == NODE_OPERATION) {
+        countUses(node->operation.leftChild);
+        countUses(node->operation.rightChild);
+    }
+}
+
+static SyntaxNode* optimizeExpression(SyntaxNode* node) {
+    if (compiler->valueSlots)
+        memset(compiler->valueSlots, 0, compiler->valueCapacity * sizeof(SyntaxNode*));
+    compiler->valueCount = 0;
+    
+    node = simplifyExpression(node);
+    countUses(node);
+    return node;
+}
+
+/*========================================================================
+  Constant Propagation and Dead Assignments
+
+  LPN programs are straight-line code, so one forward walk over the
+  assignments is a complete dataflow analysis: each expression is
+  simplified with the values known so far, and a variable whose
+  expression folds to a literal becomes known for the statements after
+  it. A backward walk from RES then drops every assignment whose value is
+  never read again. Only RESULT is observable, so a fully constant
+  program reduces to LDA CONST_k; STA RESULT.
+========================================================================*/
+static VariableState* findVariableState(const char* variable) {
+    for (int i = 0; i < compiler->variableStateCount; i++)
+        if (compiler->variableStates[i].variable == variable)
+            return &compiler->variableStates[i];
+    
+    if (compiler->variableStateCount == compiler->variableStateCapacity) {
+        compiler->variableStateCapacity = compiler->variableStateCapacity ? compiler->variableStateCapacity * 2 : 64;
+        compiler->variableStates = countedRealloc(compiler->variableStates, compiler->variableStateCapacity * sizeof(VariableState));
+        if (!compiler->variableStates) {
+            perror("Erro na alocação de memória");
+            exit(1);
+        }
+    }
+    VariableState* state = &compiler->variableStates[compiler->variableStateCount++];
+    state->variable = variable;
+    state->value = -1;
+    state->live = false;
+    return state;
+}
+
+static int constantValue(const char* identifier) {
+    for (int i = 0; i < compiler->variableStateCount; i++)
+        if (compiler->variableStates[i].variable == identifier)
+            return compiler->variableStates[i].value;
+    return -1;
+}
+
+static void markUses(SyntaxNode* node) {
+    if (!node)
+        return;
+    if (node->category == NODE_IDENTIFIER)
+        findVariableState(node->identifier)->live = true;
+    else if (node->category == NODE_OPERATION) {
+        markUses(node->operation.leftChild);
+        markUses(node->operation.rightChild);
+    }
+}
+
+static void propagateConstants() {
+    int commandCount = 0;
+    for (Command* cmd = compiler->commandList; cmd; cmd = cmd->next) {
+        cmd->expression = optimizeExpression(cmd->expression);
+        SyntaxNode* expr = cmd->expression;
+        findVariableState(cmd->variable)->value =
+            compiler->propagateEnabled && expr && expr->category == NODE_LITERAL ? expr->value : -1;
+        commandCount++;
+    }
+    compiler->program.output = optimizeExpression(compiler->program.output);
+    
+    Command** commands = arenaAlloc(&compiler->arena, (commandCount + 1) * sizeof(Command*));
+    int count = 0;
+    for (Command* cmd = compiler->commandList; cmd; cmd = cmd->next)
+        commands[count++] = cmd;
+    
+    markUses(compiler->program.output);
+    int kept = 0;
+    for (int i = count - 1; i >= 0; i--) {
+        VariableState* state = findVariableState(commands[i]->variable);
+        if (!state->live) {
+            commands[i] = NULL;
+            continue;
+        }
+        state->live = false;
+        markUses(commands[i]->expression);
+        kept++;
+    }
+    
+    compiler->commandList = compiler->lastCommand = NULL;
+    for (int i = 0; i < count; i++) {
+        if (!commands[i])
+            continue;
+        commands[i]->next = NULL;
+        if (compiler->lastCommand)
+            compiler->lastCommand->next = commands[i];
+        else
+            compiler->commandList = commands[i];
+        compiler->lastCommand = commands[i];
+    }
+    compiler->removedAssignments = count - kept;
+}
+
+/*========================================================================
+  Symbol Table for Assembly Generation
+
+  Every data word of the listing, in order of creation. Names are interned
+  and indexed by an open-addressing hash table; constants have a second
+  index keyed by value, so CONST_k is found without building its name.
+  A symbol's category, not its name prefix, says what it is.
+========================================================================*/
+static void* growArray(void* array, size_t count, size_t size) {
+    array = countedRealloc(array, count * size);
+    if (!array) {
+        perror("Erro na alocação de memória");
+        exit(1);
+    }
+    return array;
+}
+
+static size_t nameLength(const char* identifier) {
+    return strnlen(identifier, MAX_NAME_LENGTH);
+}
+
+// Index slot holding the name, or the empty slot where it would go
+static size_t symbolSlot(const char* identifier, size_t length) {
+    size_t mask = compiler->symbolIndexCapacity - 1;
+    size_t slot = hashText(identifier, length) & mask;
+    while (compiler->symbolIndex[slot] >= 0) {
+        const char* name = compiler->symbols[compiler->symbolIndex[slot]].identifier;
+        if (strncmp(name, identifier, length) == 0 && name[length] == '\0')
+            break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int findSymbol(const char* identifier) {
+    if (compiler->symbolIndexCapacity == 0)
+        return -1;
+    return compiler->symbolIndex[symbolSlot(identifier, nameLength(identifier))];
+}
+
+static int addSymbol(const char* identifier, SymbolCategory category) {
+    int existing = findSymbol(identifier);
+    if (existing >= 0)
+        return existing;
+    
+    if (2 * (size_t)(compiler->symbolCount + 1) > compiler->symbolIndexCapacity) {
+        compiler->symbolIndexCapacity = compiler->symbolIndexCapacity ? compiler->symbolIndexCapacity * 2 : 256;
+        compiler->symbolIndex = growArray(compiler->symbolIndex, compiler->symbolIndexCapacity, sizeof(int));
+        memset(compiler->symbolIndex, -1, compiler->symbolIndexCapacity * sizeof(int));
+        for (int i = 0; i < compiler->symbolCount; i++) {
+            const char* name = compiler->symbols[i].identifier;
+            compiler->symbolIndex[symbolSlot(name, strlen(name))] = i;
+        }
+    }
+    if (compiler->symbolCount == compiler->symbolCapacity) {
+        compiler->symbolCapacity = compiler->symbolCapacity ? compiler->symbolCapacity * 2 : 256;
+        compiler->symbols = growArray(compiler->symbols, compiler->symbolCapacity, sizeof(Symbol));
+    }
+    
+    size_t length = nameLength(identifier);
+    Symbol* symbol = &compiler->symbols[compiler->symbolCount];
+    symbol->identifier = internName(identifier, length);
+    symbol->category = category;
+    symbol->data = 0;
+    symbol->initialized = false;
+    symbol->referenced = false;
+    compiler->symbolIndex[symbolSlot(identifier, length)] = compiler->symbolCount;
+    return compiler->symbolCount++;
+}
+
+/* Update symbol value if expression is a literal */
+static void updateSymbolValue(const char* identifier, SymbolCategory category, int value) {
+    int symbol = addSymbol(identifier, category);
+    compiler->symbols[symbol].data = value;
+    compiler->symbols[symbol].initialized = true;
+}
+
+static size_t constantSlot(int value) {
+    size_t mask = compiler->constantCapacity - 1;
+    size_t slot = ((uint32_t)value * 2654435761u) & mask;
+    while (compiler->constantSlots[slot].symbol >= 0 && compiler->constantSlots[slot].value != value)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+// Registers CONST_value in the symbol table and returns its name
+static const char* registerConstant(int value) {
+    if (2 * (compiler->constantCount + 1) > compiler->constantCapacity) {
+        size_t oldCapacity = compiler->constantCapacity;
+        ConstantSlot* oldSlots = compiler->constantSlots;
+        compiler->constantCapacity = oldCapacity ? oldCapacity * 2 : 256;
+        compiler->constantSlots = countedMalloc(compiler->constantCapacity * sizeof(ConstantSlot));
+        if (!compiler->constantSlots) {
+            perror("Erro na alocação de memória");
+            exit(1);
+        }
+        for (size_t i = 0; i < compiler->constantCapacity; i++)
+            compiler->constantSlots[i].symbol = -1;
+        for (size_t i = 0; i < oldCapacity; i++)
+            if (oldSlots[i].symbol >= 0)
+                compiler->constantSlots[constantSlot(oldSlots[i].value)] = oldSlots[i];
+        free(oldSlots);
+    }
+    
+    ConstantSlot* slot = &compiler->constantSlots[constantSlot(value)];
+    if (slot->symbol < 0) {
+        char constName[32];
+        sprintf(constName, "CONST_%d", value);
+        slot->value = value;
+        slot->symbol = addSymbol(constName, SYMBOL_CONSTANT);
+        compiler->symbols[slot->symbol].data = value;
+        compiler->symbols[slot->symbol].initialized = true;
+        compiler->constantCount++;
+    }
+    return compiler->symbols[slot->symbol].identifier;
+}
+
+static void createTempVar(char* buffer) {
+    sprintf(buffer, "TEMP_%d", compiler->tempVarCount++);
+    addSymbol(buffer, SYMBOL_TEMPORARY);
+}
+
+
+/*========================================================================
+  Instruction Buffer
+
+  Code generation appends to this buffer instead of writing text directly,
+  so the optimizer can rewrite the instruction stream and the .DATA
+  section can be printed after every constant and temporary is known.
+========================================================================*/
+static AsmItem* appendItem(ItemKind kind) {
+    if (compiler->itemCount == compiler->itemCapacity) {
+        compiler->itemCapacity = compiler->itemCapacity ? compiler->itemCapacity * 2 : 256;
+        compiler->asmItems = countedRealloc(compiler->asmItems, compiler->itemCapacity * sizeof(AsmItem));
+        if (!compiler->asmItems) {
+            perror("Erro na alocação de memória");
+            exit(1);
+        }
+    }
+    AsmItem* item = &compiler->asmItems[compiler->itemCount++];
+    memset(item, 0, sizeof(AsmItem));
+    item->kind = kind;
+    return item;
+}
+
+// Copies at most size - 1 characters and always terminates; names are
+// interned with at most MAX_NAME_LENGTH characters, so they fit whole
+static void copyField(char* dest, size_t size, const char* src) {
+    size_t length = strnlen(src, size - 1);
+    memcpy(dest, src, length);
+    dest[length] = '\0';
+}
+
+static void emitInstruction(const char* mnemonic, const char* operand) {
+    AsmItem* item = appendItem(ITEM_INSTRUCTION);
+    copyField(item->mnemonic, sizeof(item->mnemonic), mnemonic);
+    if (operand)
+        copyField(item->operand, sizeof(item->operand), operand);
+}
+
+static void emitLabel(const char* name) {
+    AsmItem* item = appendItem(ITEM_LABEL);
+    copyField(item->operand, sizeof(item->operand), name);
+}
+
+static void emitComment(const char* format, ...) {
+    AsmItem* item = appendItem(ITEM_COMMENT);
+    va_list args;
+    va_start(args, format);
+    vsnprintf(item->operand, sizeof(item->operand), format, args);
+    va_end(args);
+}
+
+/*========================================================================
+  Peephole Optimizer
+
+  Local rewrites over the instruction stream, repeated until nothing
+  changes. Windows never span a label, so branch targets stay valid;
+  comments are skipped.
+========================================================================*/
+static bool isInstruction(int i, const char* mnemonic) {
+    return i < compiler->itemCount && compiler->asmItems[i].kind == ITEM_INSTRUCTION &&
+           strcmp(compiler->asmItems[i].mnemonic, mnemonic) == 0;
+}
+
+static bool sameOperand(int i, int j) {
+    return strcmp(compiler->asmItems[i].operand, compiler->asmItems[j].operand) == 0;
+}
+
+// Instructions that only compute the accumulator (no store, no branch)
+static bool onlyWritesAccumulator(int i) {
+    return isInstruction(i, "LDA") || isInstruction(i, "ADD") || isInstruction(i, "SUB") ||
+           isInstruction(i, "AND") || isInstruction(i, "OR") || isInstruction(i, "NOT");
+}
+
+static bool readsOperand(int i) {
+    return onlyWritesAccumulator(i) && !isInstruction(i, "NOT");
+}
+
+static bool isBranch(int i) {
+    return isInstruction(i, "JMP") || isInstruction(i, "JMN") || isInstruction(i, "JMZ");
+}
+
+// Next item that is not removed and not a comment (labels included)
+static int nextItem(int i) {
+    for (i++; i < compiler->itemCount; i++)
+        if (!compiler->asmItems[i].removed && compiler->asmItems[i].kind != ITEM_COMMENT)
+            return i;
+    return compiler->itemCount;
+}
+
+static void removeItem(int i) {
+    compiler->asmItems[i].removed = true;
+}
+
+static bool peepholePass() {
+    bool changed = false;
+
+    for (int i = 0; i < compiler->itemCount; i++) {
+        if (compiler->asmItems[i].removed || compiler->asmItems[i].kind != ITEM_INSTRUCTION)
+            continue;
+        int j = nextItem(i);
+        int k = nextItem(j);
+
+        // STA X; LDA X  ->  STA X (the accumulator already holds X)
+        if (isInstruction(i, "STA") && isInstruction(j, "LDA") && sameOperand(i, j)) {
+            removeItem(j);
+            changed = true;
+        }
+        // LDA X; STA X  ->  LDA X
+        else if (isInstruction(i, "LDA") && isInstruction(j, "STA") && sameOperand(i, j)) {
+            removeItem(j);
+            changed = true;
+        }
+        // STA X; STA X  ->  STA X
+        else if (isInstruction(i, "STA") && isInstruction(j, "STA") && sameOperand(i, j)) {
+            removeItem(i);
+            changed = true;
+        }
+        // Accumulator result overwritten by a load before being used
+        else if (onlyWritesAccumulator(i) && isInstruction(j, "LDA")) {
+            removeItem(i);
+            changed = true;
+        }
+        // STA X; LDA Y; ADD X  ->  STA X; ADD Y (AC == X and addition commutes)
+        else if (isInstruction(i, "STA") && isInstruction(j, "LDA") && isInstruction(k, "ADD") &&
+                 sameOperand(i, k)) {
+            strcpy(compiler->asmItems[j].mnemonic, "ADD");
+            removeItem(k);
+            changed = true;
+        }
+        // LDA CONST_0; ADD Y  ->  LDA Y
+        else if (isInstruction(i, "LDA") && strcmp(compiler->asmItems[i].operand, "CONST_0") == 0 &&
+                 isInstruction(j, "ADD")) {
+            strcpy(compiler->asmItems[i].operand, compiler->asmItems[j].operand);
+            removeItem(j);
+            changed = true;
+        }
+        // ADD CONST_0 / SUB CONST_0 do nothing
+        else if ((isInstruction(i, "ADD") || isInstruction(i, "SUB")) &&
+                 strcmp(compiler->asmItems[i].operand, "CONST_0") == 0) {
+            removeItem(i);
+            changed = true;
+        }
+        // JMP L immediately followed by L:
+        else if (isInstruction(i, "JMP") && j < compiler->itemCount && compiler->asmItems[j].kind == ITEM_LABEL &&
+                 sameOperand(i, j)) {
+            removeItem(i);
+            changed = true;
+        }
+        // Nothing after JMP/HLT runs until the next label
+        else if (isInstruction(i, "JMP") || isInstruction(i, "HLT")) {
+            for (; j < compiler->itemCount && compiler->asmItems[j].kind == ITEM_INSTRUCTION; j = nextItem(j)) {
+                removeItem(j);
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+// Stores to temporaries that no instruction ever reads
+static bool removeDeadStores() {
+    bool changed = false;
+
+    for (int i = 0; i < compiler->itemCount; i++) {
+        if (compiler->asmItems[i].removed || !isInstruction(i, "STA") ||
+            strncmp(compiler->asmItems[i].operand, "TEMP_", 5) != 0)
+            continue;
+
+        bool read = false;
+        for (int j = 0; j < compiler->itemCount && !read; j++)
+            read = !compiler->asmItems[j].removed && readsOperand(j) && sameOperand(i, j);
+        if (!read) {
+            removeItem(i);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static void compactItems() {
+    int kept = 0;
+    for (int i = 0; i < compiler->itemCount; i++)
+        if (!compiler->asmItems[i].removed)
+            compiler->asmItems[kept++] = compiler->asmItems[i];
+    compiler->itemCount = kept;
+}
+
+static void optimizeCode() {
+    bool changed;
+    do {
+        changed = peepholePass();
+        changed |= removeDeadStores();
+    } while (changed);
+    compactItems();
+}
+
+/*========================================================================
+  Temporary Slot Allocation
+
+  Code generation takes a fresh TEMP_n for every intermediate value. After
+  the peephole pass, liveness is computed backwards over the final
+  instruction stream, repeating until the live sets at the labels stop
+  changing (the multiply and divide loops branch backwards). Each
+  temporary gets the interval of positions where it is live, read or
+  written, and a linear scan over the intervals reuses the slot of every
+  temporary whose interval has ended.
+========================================================================*/
+typedef struct {
+    const char* name;
+    int ordinal;
+} LabelEntry;
+
+static int compareLabels(const void* a, const void* b) {
+    return strcmp(((const LabelEntry*)a)->name, ((const LabelEntry*)b)->name);
+}
+
+// TEMP_n operand of a load, arithmetic or store; -1 for anything else
+static int tempOperand(int i) {
+    if (compiler->asmItems[i].kind != ITEM_INSTRUCTION || isBranch(i) ||
+        strncmp(compiler->asmItems[i].operand, "TEMP_", 5) != 0)
+        return -1;
+    return atoi(compiler->asmItems[i].operand + 5);
+}
+
+/*
+ * One backward step over item i. For an instruction, live is turned from
+ * the live-in of the next item into the live-out of i, passed to visit
+ * (if any), then turned into the live-in of i. Returns true when the live
+ * set recorded for a label changes.
+ */
+static bool liveStep(int i, uint64_t* live, uint64_t* labelLive, const int* labelOf, int words,
+                     void (*visit)(int, const uint64_t*)) {
+    if (compiler->asmItems[i].kind == ITEM_LABEL) {
+        uint64_t* recorded = &labelLive[(size_t)labelOf[i] * words];
+        if (memcmp(recorded, live, words * sizeof(uint64_t)) == 0)
+            return false;
+        memcpy(recorded, live, words * sizeof(uint64_t));
+        return true;
+    }
+    if (compiler->asmItems[i].kind != ITEM_INSTRUCTION)
+        return false;
+    
+    const uint64_t* target = labelOf[i] >= 0 ? &labelLive[(size_t)labelOf[i] * words] : NULL;
+    if (isInstruction(i, "HLT"))
+        memset(live, 0, words * sizeof(uint64_t));
+    else if (isInstruction(i, "JMP") && target)
+        memcpy(live, target, words * sizeof(uint64_t));
+    else if (isBranch(i) && target)
+        for (int w = 0; w < words; w++)
+            live[w] |= target[w];
+    
+    if (visit)
+        visit(i, live);
+    
+    int temp = tempOperand(i);
+    if (temp >= 0) {
+        if (isInstruction(i, "STA"))
+            live[temp / 64] &= ~(1ULL << (temp % 64));
+        else
+            live[temp / 64] |= 1ULL << (temp % 64);
+    }
+    return false;
+}
+
+static void extendInterval(int temp, int position) {
+    if (position < compiler->intervalStart[temp])
+        compiler->intervalStart[temp] = position;
+    if (position > compiler->intervalEnd[temp])
+        compiler->intervalEnd[temp] = position;
+}
+
+static int compareIntervals(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    if (compiler->intervalStart[x] != compiler->intervalStart[y])
+        return compiler->intervalStart[x] - compiler->intervalStart[y];
+    return x - y;
+}
+
+// Records i in the interval of every temporary live after it or used by it
+static void recordLiveOut(int i, const uint64_t* live) {
+    int count = 0;
+    for (int w = 0; w < (compiler->tempVarCount + 63) / 64; w++) {
+        for (uint64_t bits = live[w]; bits; bits &= bits - 1) {
+            extendInterval(w * 64 + __builtin_ctzll(bits), i);
+            count++;
+        }
+    }
+    if (count > compiler->peakLiveTemps)
+        compiler->peakLiveTemps = count;
+    
+    int temp = tempOperand(i);
+    if (temp >= 0)
+        extendInterval(temp, i);
+}
+
+static void allocateTemporaries() {
+    int temps = compiler->tempVarCount;
+    if (temps == 0)
+        return;
+    int words = (temps + 63) / 64;
+    
+    // Number the labels and resolve each branch to its label's number
+    int* labelOf = countedMalloc(compiler->itemCount * sizeof(int));
+    LabelEntry* labels = countedMalloc(compiler->itemCount * sizeof(LabelEntry));
+    int labelCount = 0;
+    for (int i = 0; i < compiler->itemCount; i++) {
+        labelOf[i] = -1;
+        if (compiler->asmItems[i].kind == ITEM_LABEL) {
+            labels[labelCount].name = compiler->asmItems[i].operand;
+            labels[labelCount].ordinal = labelCount;
+            labelOf[i] = labelCount++;
+        }
+    }
+    qsort(labels, labelCount, sizeof(LabelEntry), compareLabels);
+    for (int i = 0; i < compiler->itemCount; i++) {
+        if (!isBranch(i))
+            continue;
+        LabelEntry key = { compiler->asmItems[i].operand, 0 };
+        LabelEntry* found = bsearch(&key, labels, labelCount, sizeof(LabelEntry), compareLabels);
+        if (found)
+            labelOf[i] = found->ordinal;
+    }
+    
+    uint64_t* labelLive = countedCalloc((size_t)(labelCount ? labelCount : 1) * words, sizeof(uint64_t));
+    uint64_t* live = countedMalloc(words * sizeof(uint64_t));
+    compiler->intervalStart = countedMalloc(temps * sizeof(int));
+    compiler->intervalEnd = countedMalloc(temps * sizeof(int));
+    int* slotOf = countedMalloc(temps * sizeof(int));
+    int* order = countedMalloc(temps * sizeof(int));
+    int* active = countedMalloc(temps * sizeof(int));
+    bool* slotBusy = countedCalloc(temps, sizeof(bool));
+    if (!labelOf || !labels || !labelLive || !live || !compiler->intervalStart || !compiler->intervalEnd ||
+        !slotOf || !order || !active || !slotBusy) {
+        perror("Erro na alocação de memória");
+        exit(1);
+    }
+    
+    bool changed;
+    do {
+        changed = false;
+        memset(live, 0, words * sizeof(uint64_t));
+        for (int i = compiler->itemCount - 1; i >= 0; i--)
+            changed |= liveStep(i, live, labelLive, labelOf, words, NULL);
+    } while (changed);
+    
+    for (int t = 0; t < temps; t++) {
+        compiler->intervalStart[t] = compiler->itemCount;
+        compiler->intervalEnd[t] = -1;
+    }
+    memset(live, 0, words * sizeof(uint64_t));
+    for (int i = compiler->itemCount - 1; i >= 0; i--)
+        liveStep(i, live, labelLive, labelOf, words, recordLiveOut);
+    
+    // Linear scan over the intervals in order of start
+    int used = 0;
+    for (int t = 0; t < temps; t++)
+        if (compiler->intervalEnd[t] >= 0)
+            order[used++] = t;
+    qsort(order, used, sizeof(int), compareIntervals);
+    
+    int activeCount = 0;
+    compiler->tempsBeforeAllocation = used;
+    compiler->tempSlotCount = 0;
+    for (int k = 0; k < used; k++) {
+        int t = order[k];
+        int kept = 0;
+        for (int a = 0; a < activeCount; a++) {
+            if (compiler->intervalEnd[active[a]] < compiler->intervalStart[t])
+                slotBusy[slotOf[active[a]]] = false;
+            else
+                active[kept++] = active[a];
+        }
+        activeCount = kept;
+        
+        int slot = 0;
+        while (slotBusy[slot])
+            slot++;
+        slotBusy[slot] = true;
+        slotOf[t] = slot;
+        active[activeCount++] = t;
+        if (slot + 1 > compiler->tempSlotCount)
+            compiler->tempSlotCount = slot + 1;
+    }
+    
+    for (int i = 0; i < compiler->itemCount; i++) {
+        int temp = tempOperand(i);
+        if (temp < 0)
+            continue;
+        snprintf(compiler->asmItems[i].operand, sizeof(compiler->asmItems[i].operand), "TEMP_%d", slotOf[temp]);
+    }
+    
+    free(labelOf);
+    free(labels);
+    free(labelLive);
+    free(live);
+    free(compiler->intervalStart);
+    free(compiler->intervalEnd);
+    free(slotOf);
+    free(order);
+    free(active);
+    free(slotBusy);
+}
+
+// Marks the symbols the current instruction stream reads or writes
+static void markReferences() {
+    for (int i = 0; i < compiler->symbolCount; i++)
+        compiler->symbols[i].referenced = false;
+    for (int i = 0; i < compiler->itemCount; i++) {
+        if (compiler->asmItems[i].kind != ITEM_INSTRUCTION || compiler->asmItems[i].removed ||
+            isBranch(i) || !compiler->asmItems[i].operand[0])
+            continue;
+        int symbol = findSymbol(compiler->asmItems[i].operand);
+        if (symbol >= 0)
+            compiler->symbols[symbol].referenced = true;
+    }
+}
+
+static int countInstructions() {
+    int count = 0;
+    for (int i = 0; i < compiler->itemCount; i++)
+        if (compiler->asmItems[i].kind == ITEM_INSTRUCTION)
+            count++;
+    return count;
+}
+
+static int countDataWords();
+
+// Function declarations to avoid compilation errors
+static void generateExprCode(SyntaxNode* node);
+static void generateAssignmentCode(Command* cmd);
+static void generateAssemblyCode();
+
+/*========================================================================
+  Evaluation Order
+
+  Neander has a single accumulator and every binary instruction takes its
+  second operand from memory. A subtree whose value is already in memory
+  (variable, constant or computed shared subexpression) can be used as
+  that operand directly; anything else has to be computed first and
+  spilled to a temporary. Each subtree is labeled with its Sethi-Ullman
+  number, the temporaries its evaluation needs, and the generator computes
+  the side with the larger number first so fewer values are held in
+  memory at once.
+========================================================================*/
+static bool isAddressable(SyntaxNode* node) {
+    return node->category != NODE_OPERATION || node->valueName != NULL;
+}
+
+// Memory operand for an addressable node
+static const char* operandName(SyntaxNode* node) {
+    if (node->category == NODE_OPERATION)
+        return node->valueName;
+    if (node->category == NODE_IDENTIFIER) {
+        addSymbol(node->identifier, SYMBOL_USER);
+        return node->identifier;
+    }
+    return registerConstant(node->value);
+}
+
+static int evaluationNeed(SyntaxNode* node) {
+    if (node->category != NODE_OPERATION)
+        return 0;
+    if (node->need >= 0)
+        return node->need;
+    
+    SyntaxNode* left = node->operation.leftChild;
+    SyntaxNode* right = node->operation.rightChild;
+    int a = evaluationNeed(left);
+    int b = evaluationNeed(right);
+    int larger = a > b ? a : b;
+    int smaller = a > b ? b : a;
+    
+    switch (node->operation.operator) {
+        case '+':
+            if (right->category != NODE_OPERATION) node->need = a;
+            else if (left->category != NODE_OPERATION) node->need = b;
+            else node->need = a == b ? a + 1 : larger;
+            break;
+        case '-':
+            // the right side is computed first and held while the left one is
+            if (right->category != NODE_OPERATION) node->need = a;
+            else node->need = b > a + 1 ? b : a + 1;
+            break;
+        default:
+            // both operands are stored, then the loop uses four temporaries
+            node->need = smaller + 1 > larger ? smaller + 1 : larger;
+            if (node->need < 4)
+                node->need = 4;
+            break;
+    }
+    return node->need;
+}
+
+// Evaluates both operands into temporaries, the one needing more temporaries first
+static void generateOperands(SyntaxNode* left, const char* leftTemp, SyntaxNode* right, const char* rightTemp) {
+    if (evaluationNeed(left) > evaluationNeed(right)) {
+        generateExprCode(left);
+        emitInstruction("STA", leftTemp);
+        generateExprCode(right);
+        emitInstruction("STA", rightTemp);
+    } else {
+        generateExprCode(right);
+        emitInstruction("STA", rightTemp);
+        generateExprCode(left);
+        emitInstruction("STA", leftTemp);
+    }
+}
+
+/*========================================================================
+  Multiplication Cost Model
+
+  Neander has no multiply instruction. A known multiplier m can be unrolled
+  into m additions, which is fast but grows with the value (x * 200 does
+  not fit in memory). The shift-and-add loop costs a fixed number of
+  instructions and runs at most 8 iterations. The compiler picks whichever
+  form takes fewer instructions.
+========================================================================*/
+#define MUL_LOOP_COST 24   // loop instructions, excluding the operands
+#define DIV_LOOP_COST 43   // division routine for a divisor unknown at compile time
+
+// Value of a literal or of a variable whose last assignment was a literal; -1 if unknown
+static int knownValue(SyntaxNode* node) {
+    if (node->category == NODE_LITERAL)
+        return node->value;
+    if (node->category == NODE_IDENTIFIER) {
+        int symbol = findSymbol(node->identifier);
+        if (symbol >= 0)
+            return compiler->symbols[symbol].initialized ? compiler->symbols[symbol].data : -1;
+    }
+    return -1;
+}
+
+// Rough number of instructions generateExprCode emits for a subtree
+static int estimateCost(SyntaxNode* node) {
+    if (node->category != NODE_OPERATION)
+        return 1;
+    
+    int left = estimateCost(node->operation.leftChild);
+    int right = estimateCost(node->operation.rightChild);
+    switch (node->operation.operator) {
+        case '*': return left + right + MUL_LOOP_COST;
+        case '/':
+        case '%': return left + right + DIV_LOOP_COST;
+        default:  return left + right + 2;
+    }
+}
+
+// LDA x; ADD x; ... with m - 1 additions (a computed x is stored once first)
+static int unrolledMultiplyCost(SyntaxNode* left, int multiplier) {
+    if (multiplier == 0)
+        return 1;
+    int spill = left->category == NODE_OPERATION && multiplier > 1;
+    return estimateCost(left) + spill + multiplier - 1;
+}
+
+static int loopMultiplyCost(SyntaxNode* left, SyntaxNode* right) {
+    return estimateCost(left) + estimateCost(right) + MUL_LOOP_COST;
+}
+
+/*
+ * Shift-and-add over the bits of the multiplier, lowest first. MASK walks
+ * the bits by doubling (ADD self), the multiplicand doubles alongside, and
+ * each set bit is cleared from the multiplier after being added, so the
+ * loop stops as soon as no set bits remain.
+ *
+ *       B = right; A = left; R = 0; MASK = 1
+ *   L:  if B == 0 goto DONE
+ *       if (B AND MASK) == 0 goto SKIP
+ *       B = B - MASK; R = R + A
+ *   S:  A = A + A; MASK = MASK + MASK; goto L
+ *   D:  AC = R
+ */
+static void generateMultiplyLoop(SyntaxNode* left, SyntaxNode* right) {
+    char multiplier[64], multiplicand[64], result[64], mask[64];
+    char loopLabel[64], skipLabel[64], doneLabel[64];
+    
+    createTempVar(multiplier);
+    createTempVar(multiplicand);
+    createTempVar(result);
+    createTempVar(mask);
+    sprintf(loopLabel, "MUL_LOOP_%d", compiler->mulLabelCount);
+    sprintf(skipLabel, "MUL_SKIP_%d", compiler->mulLabelCount);
+    sprintf(doneLabel, "MUL_DONE_%d", compiler->mulLabelCount++);
+    
+    generateOperands(left, multiplicand, right, multiplier);
+    emitInstruction("LDA", "CONST_0");
+    emitInstruction("STA", result);
+    emitInstruction("LDA", "CONST_1");
+    emitInstruction("STA", mask);
+    
+    emitLabel(loopLabel);
+    emitInstruction("LDA", multiplier);
+    emitInstruction("JMZ", doneLabel);
+    emitInstruction("AND", mask);
+    emitInstruction("JMZ", skipLabel);
+    emitInstruction("LDA", multiplier);
+    emitInstruction("SUB", mask);
+    emitInstruction("STA", multiplier);
+    emitInstruction("LDA", result);
+    emitInstruction("ADD", multiplicand);
+    emitInstruction("STA", result);
+    
+    emitLabel(skipLabel);
+    emitInstruction("LDA", multiplicand);
+    emitInstruction("ADD", multiplicand);
+    emitInstruction("STA", multiplicand);
+    emitInstruction("LDA", mask);
+    emitInstruction("ADD", mask);
+    emitInstruction("STA", mask);
+    emitInstruction("JMP", loopLabel);
+    
+    emitLabel(doneLabel);
+    emitInstruction("LDA", result);
+}
+
+/*
+ * Restoring division, one quotient bit per iteration and always 8
+ * iterations. The dividend is shifted left out of Q into the partial
+ * remainder R, and quotient bits are shifted into Q from the right. After
+ * the loop, Q holds the quotient and R the remainder.
+ *
+ * Neander has no carry flag, so R >= D is tested with the sign of R - D.
+ * This is exact while D < 128: R < D, so 2R + 1 - D stays within
+ * (-128, 128). A divisor of 128 or more gives a quotient of 0 or 1 and is
+ * handled apart. x / 0 = 0 and x % 0 = x, so x = (x / y) * y + x % y
+ * always holds.
+ *
+ *       Q = left; D = right; R = 0; COUNT = 255
+ *       if D == 0 goto SMALL; if D >= 128 goto BIG
+ *   L:  R = 2R + msb(Q); Q = 2Q
+ *       if R - D >= 0: R = R - D; Q = Q + 1
+ *       COUNT = 2 * COUNT; if COUNT < 0 goto L   (8 doublings reach 0)
+ *       goto DONE
+ *   B:  if Q < 128 goto SMALL
+ *       if Q - D >= 0: quotient 1, remainder Q - D; goto DONE
+ *   S:  quotient 0, remainder Q
+ *   D:  AC = Q (or R for '%')
+ *
+ * knownDivisor is the divisor's value when it is known at compile time
+ * (-1 otherwise). A known divisor between 1 and 127 skips both special
+ * cases.
+ */
+static void generateDivision(SyntaxNode* left, SyntaxNode* right, bool remainder, int knownDivisor) {
+    char quotient[64], divisor[64], rest[64], count[64];
+    char loopLabel[64], oneLabel[64], compareLabel[64], nextLabel[64];
+    char bigLabel[64], bothLabel[64], smallLabel[64], doneLabel[64];
+    
+    createTempVar(quotient);
+    createTempVar(divisor);
+    createTempVar(rest);
+    createTempVar(count);
+    sprintf(loopLabel, "DIV_LOOP_%d", compiler->divLabelCount);
+    sprintf(oneLabel, "DIV_ONE_%d", compiler->divLabelCount);
+    sprintf(compareLabel, "DIV_CMP_%d", compiler->divLabelCount);
+    sprintf(nextLabel, "DIV_NEXT_%d", compiler->divLabelCount);
+    sprintf(bigLabel, "DIV_BIG_%d", compiler->divLabelCount);
+    sprintf(bothLabel, "DIV_BOTH_%d", compiler->divLabelCount);
+    sprintf(smallLabel, "DIV_SMALL_%d", compiler->divLabelCount);
+    sprintf(doneLabel, "DIV_DONE_%d", compiler->divLabelCount++);
+    
+    bool general = knownDivisor < 1 || knownDivisor >= 128;
+    registerConstant(255);
+    
+    generateOperands(left, quotient, right, divisor);
+    emitInstruction("LDA", "CONST_0");
+    emitInstruction("STA", rest);
+    emitInstruction("LDA", "CONST_255");
+    emitInstruction("STA", count);
+    if (general) {
+        emitInstruction("LDA", divisor);
+        emitInstruction("JMZ", smallLabel);
+        emitInstruction("JMN", bigLabel);
+    }
+    
+    emitLabel(loopLabel);
+    emitInstruction("LDA", quotient);
+    emitInstruction("JMN", oneLabel);
+    emitInstruction("LDA", rest);
+    emitInstruction("ADD", rest);
+    emitInstruction("JMP", compareLabel);
+    emitLabel(oneLabel);
+    emitInstruction("LDA", rest);
+    emitInstruction("ADD", rest);
+    emitInstruction("ADD", "CONST_1");
+    emitLabel(compareLabel);
+    emitInstruction("STA", rest);
+    emitInstruction("LDA", quotient);
+    emitInstruction("ADD", quotient);
+    emitInstruction("STA", quotient);
+    emitInstruction("LDA", rest);
+    emitInstruction("SUB", divisor);
+    emitInstruction("JMN", nextLabel);
+    emitInstruction("STA", rest);
+    emitInstruction("LDA", quotient);
+    emitInstruction("ADD", "CONST_1");
+    emitInstruction("STA", quotient);
+    emitLabel(nextLabel);
+    emitInstruction("LDA", count);
+    emitInstruction("ADD", count);
+    emitInstruction("STA", count);
+    emitInstruction("JMN", loopLabel);
+    
+    if (general) {
+        emitInstruction("JMP", doneLabel);
+        
+        emitLabel(bigLabel);
+        emitInstruction("LDA", quotient);
+        emitInstruction("JMN", bothLabel);
+        emitLabel(smallLabel);
+        if (remainder) {
+            emitInstruction("LDA", quotient);
+            emitInstruction("STA", rest);
+        } else {
+            emitInstruction("LDA", "CONST_0");
+            emitInstruction("STA", quotient);
+        }
+        emitInstruction("JMP", doneLabel);
+        emitLabel(bothLabel);
+        emitInstruction("SUB", divisor);
+        emitInstruction("JMN", smallLabel);
+        if (remainder) {
+            emitInstruction("STA", rest);
+        } else {
+            emitInstruction("LDA", "CONST_1");
+            emitInstruction("STA", quotient);
+        }
+    }
+    
+    emitLabel(doneLabel);
+    emitInstruction("LDA", remainder ? rest : quotient);
+}
+
+// Improved function for code generation from expressions
+static void generateExprCode(SyntaxNode* node) {
+    if (node->valueName) {
+        // Common subexpression already computed earlier in this expression
+        emitInstruction("LDA", node->valueName);
+    }
+    else if (node->category == NODE_LITERAL) {
+        // Ensure constant exists in symbol table
+        emitInstruction("LDA", registerConstant(node->value));
+    } 
+    else if (node->category == NODE_IDENTIFIER) {
+        addSymbol(node->identifier, SYMBOL_USER);
+        emitInstruction("LDA", node->identifier);
+    } 
+    else if (node->category == NODE_OPERATION) {
+        char op = node->operation.operator;
+        
+        if (op == '+' || op == '-') {
+            SyntaxNode* left = node->operation.leftChild;
+            SyntaxNode* right = node->operation.rightChild;
+            const char* mnemonic = op == '+' ? "ADD" : "SUB";
+            
+            if (left->category == NODE_LITERAL && right->category == NODE_LITERAL) {
+                // Case: number op number (optimize at compile time)
+                int result = (op == '+' ? left->value + right->value : left->value - right->value) & 0xFF;
+                emitInstruction("LDA", registerConstant(result));
+            }
+            else if (isAddressable(right)) {
+                // Right side already in memory: use it as the operand
+                generateExprCode(left);
+                emitInstruction(mnemonic, operandName(right));
+            }
+            else if (op == '+') {
+                // Addition commutes: evaluate the side that needs more temporaries first
+                SyntaxNode* first = right;
+                SyntaxNode* second = left;
+                if (!isAddressable(left) && evaluationNeed(left) >= evaluationNeed(right)) {
+                    first = left;
+                    second = right;
+                }
+                generateExprCode(first);
+                if (isAddressable(second)) {
+                    emitInstruction("ADD", operandName(second));
+                } else {
+                    char firstTemp[64];
+                    createTempVar(firstTemp);
+                    emitInstruction("STA", firstTemp);
+                    generateExprCode(second);
+                    emitInstruction("ADD", firstTemp);
+                }
+            }
+            else {
+                // Subtraction does not commute and SUB takes its operand from memory,
+                // so the right side is evaluated and stored first
+                char rightTemp[64];
+                generateExprCode(right);
+                createTempVar(rightTemp);
+                emitInstruction("STA", rightTemp);
+                generateExprCode(left);
+                emitInstruction("SUB", rightTemp);
+            }
+        } 
+        else if (op == '*') {
+            SyntaxNode* left = node->operation.leftChild;
+            SyntaxNode* right = node->operation.rightChild;
+            
+            // Multiplication commutes: keep the known (and smaller) operand on the right
+            int leftValue = knownValue(left) >= 0 ? knownValue(left) % 256 : -1;
+            int rightValue = knownValue(right) >= 0 ? knownValue(right) % 256 : -1;
+            if (leftValue >= 0 && (rightValue < 0 || leftValue < rightValue)) {
+                SyntaxNode* swap = left;
+                left = right;
+                right = swap;
+            }
+            
+            int multiplier = knownValue(right);
+            if (multiplier >= 0)
+                multiplier %= 256;  // the result wraps at 8 bits anyway
+            
+            if (multiplier >= 0 && unrolledMultiplyCost(left, multiplier) <= loopMultiplyCost(left, right)) {
+                // Small known multiplier: repeated addition is shorter and faster
+                if (multiplier == 0) {
+                    emitInstruction("LDA", "CONST_0");
+                } else {
+                    generateExprCode(left);
+                    const char* addend = NULL;
+                    char leftTemp[64];
+                    if (isAddressable(left)) {
+                        addend = operandName(left);
+                    } else if (multiplier > 1) {
+                        // ADD reads memory: keep the computed multiplicand in a temporary
+                        createTempVar(leftTemp);
+                        emitInstruction("STA", leftTemp);
+                        addend = leftTemp;
+                    }
+                    for (int i = 1; i < multiplier; i++)
+                        emitInstruction("ADD", addend);
+                }
+            } 
+            else {
+                generateMultiplyLoop(left, right);
+            }
+        } 
+        else if (op == '/' || op == '%') {
+            int leftValue = knownValue(node->operation.leftChild);
+            int rightValue = knownValue(node->operation.rightChild);
+            
+            // Division by zero known at compile time: x / 0 = 0 and x % 0 = x
+            if (rightValue >= 0 && rightValue % 256 == 0) {
+                logMessage("Erro: Divisão por 0 detectada\n");
+                emitComment("Erro: Divisão por 0");
+                if (op == '%')
+                    generateExprCode(node->operation.leftChild);
+                else
+                    emitInstruction("LDA", "CONST_0");
+            }
+            else if (node->operation.leftChild->category == NODE_LITERAL && 
+                node->operation.rightChild->category == NODE_LITERAL) {
+                // Optimize constant division, with the machine's 8-bit operands
+                int result = op == '/' ? (leftValue % 256) / (rightValue % 256)
+                                       : (leftValue % 256) % (rightValue % 256);
+                emitInstruction("LDA", registerConstant(result));
+            } 
+            else {
+                generateDivision(node->operation.leftChild, node->operation.rightChild,
+                                 op == '%', rightValue >= 0 ? rightValue % 256 : -1);
+            }
+        }
+        
+        if (node->useCount > 1) {
+            // Shared subexpression: keep the value for its other uses
+            char valueTemp[64];
+            createTempVar(valueTemp);
+            emitInstruction("STA", valueTemp);
+            node->valueName = internName(valueTemp, strlen(valueTemp));
+        }
+    }
+}
+
+static void generateAssignmentCode(Command* cmd) {
+    // If assignment is a literal number, update symbol value directly
+    if (cmd->expression && cmd->expression->category == NODE_LITERAL) {
+        updateSymbolValue(cmd->variable, SYMBOL_USER, cmd->expression->value);
+        // Generate direct assignment code
+        emitInstruction("LDA", registerConstant(cmd->expression->value));
+        emitInstruction("STA", cmd->variable);
+    } else {
+        // For complex expressions, generate normal code
+        generateExprCode(cmd->expression);
+        int symbol = addSymbol(cmd->variable, SYMBOL_USER);
+        emitInstruction("STA", cmd->variable);
+        
+        // The value is no longer a compile-time constant
+        compiler->symbols[symbol].initialized = false;
+    }
+}
+
+static int countDataWords() {
+    int count = 0;
+    markReferences();
+    for (int i = 0; i < compiler->symbolCount; i++)
+        if (compiler->symbols[i].referenced)
+            count++;
+    return count;
+}
+
+static void generateAssemblyCode() {
+    PhaseMark mark = startPhase();
+    
+    /* Fixed header */
+    updateSymbolValue("UNITY", SYMBOL_BUILTIN, 1);
+    registerConstant(0);
+    registerConstant(1);
+    updateSymbolValue("NEGATIVE", SYMBOL_BUILTIN, 255);
+    addSymbol("RESULT", SYMBOL_BUILTIN);
+    
+    /* Fold and propagate constants, share subexpressions, drop dead assignments */
+    if (compiler->optimizeEnabled)
+        propagateConstants();
+    
+    /* Pre-processing to ensure all constants are defined */
+    Command* cmd = compiler->commandList;
+    while (cmd) {
+        if (cmd->expression && cmd->expression->category == NODE_LITERAL) {
+            registerConstant(cmd->expression->value);
+        }
+        cmd = cmd->next;
+    }
+    
+    /* Generate instructions for assignments */
+    cmd = compiler->commandList;
+    while (cmd) {
+        emitComment("Assignment: %s = ...", cmd->variable);
+        generateAssignmentCode(cmd);
+        cmd = cmd->next;
+    }
+    
+    /* Generate code for final expression */
+    emitComment("Result expression");
+    generateExprCode(compiler->program.output);
+    emitInstruction("STA", "RESULT");
+    emitInstruction("HLT", NULL);
+    
+    int instructionsBefore = countInstructions();
+    int wordsBefore = 2 * instructionsBefore + countDataWords();
+    finishPhase(NEANDER_PHASE_CODEGEN, &mark);
+    
+    mark = startPhase();
+    if (compiler->optimizeEnabled) {
+        optimizeCode();
+        allocateTemporaries();
+    }
+    finishPhase(NEANDER_PHASE_OPTIMIZE, &mark);
+    int instructionsAfter = countInstructions();
+    int wordsAfter = 2 * instructionsAfter + countDataWords();
+    
+    logMessage("Código assembly gerado!\n");
+    logMessage("Otimização: %d -> %d instruções, %d -> %d palavras de memória\n",
+               instructionsBefore, instructionsAfter, wordsBefore, wordsAfter);
+    if (compiler->tempsBeforeAllocation)
+        logMessage("Temporários: %d -> %d posições de memória (pico de %d vivos ao mesmo tempo)\n",
+                   compiler->tempsBeforeAllocation, compiler->tempSlotCount, compiler->peakLiveTemps);
+    if (compiler->removedAssignments)
+        logMessage("Atribuições sem efeito no resultado removidas: %d\n", compiler->removedAssignments);
+}
+
+/*========================================================================
+  Output
+
+  The listing is the .asm text the assembler reads. The binary backend
+  feeds the same instruction buffer straight into the shared Neander
+  assembler (neander.c), so the image is identical to assembling the
+  listing, without writing and re-parsing text.
+========================================================================*/
+// Initial value of a data word; false when it starts undefined (DB ?)
+static bool initialDataValue(int i, int* value) {
+    const Symbol* symbol = &compiler->symbols[i];
+    if (symbol->category == SYMBOL_TEMPORARY || !symbol->initialized)
+        return false;
+    *value = symbol->data;
+    return true;
+}
+
+static void writeListing(FILE* asmOutput) {
+    fprintf(asmOutput, "; Assembly code generated by compiler\n");
+    fprintf(asmOutput, "; Program: %s\n\n", compiler->program.title);
+    
+    /* Only the symbols the final code still uses take memory */
+    fprintf(asmOutput, ".DATA\n");
+    markReferences();
+    for (int i = 0; i < compiler->symbolCount; i++) {
+        int value;
+        if (!compiler->symbols[i].referenced)
+            continue;
+        if (initialDataValue(i, &value))
+            fprintf(asmOutput, "%s DB %d\n", compiler->symbols[i].identifier, value);
+        else
+            fprintf(asmOutput, "%s DB ?\n", compiler->symbols[i].identifier);
+    }
+    
+    fprintf(asmOutput, "\n.CODE\n");
+    fprintf(asmOutput, ".ORG 0\n");
+    
+    for (int i = 0; i < compiler->itemCount; i++) {
+        if (compiler->asmItems[i].kind == ITEM_LABEL)
+            fprintf(asmOutput, "%s:\n", compiler->asmItems[i].operand);
+        else if (compiler->asmItems[i].kind == ITEM_COMMENT)
+            fprintf(asmOutput, "; %s\n", compiler->asmItems[i].operand);
+        else if (compiler->asmItems[i].operand[0])
+            fprintf(asmOutput, "%s %s\n", compiler->asmItems[i].mnemonic, compiler->asmItems[i].operand);
+        else
+            fprintf(asmOutput, "%s\n", compiler->asmItems[i].mnemonic);
+    }
+}
+
+// Same steps the assembler takes for the listing: data, then code, then backpatching.
+// Errors carry the line the item has in the listing.
+static bool assembleProgram(NeanderAssembler* image) {
+    neander_init(image);
+    
+    int line = 4;   // title, program name, blank line, .DATA
+    markReferences();
+    for (int i = 0; i < compiler->symbolCount; i++) {
+        int value = 0;
+        if (!compiler->symbols[i].referenced)
+            continue;
+        initialDataValue(i, &value);
+        if (!neander_define_data(image, compiler->symbols[i].identifier, value, ++line))
+            return false;
+    }
+    
+    line += 3;      // blank line, .CODE, .ORG 0
+    for (int i = 0; i < compiler->itemCount; i++) {
+        bool ok = true;
+        line++;
+        if (compiler->asmItems[i].kind == ITEM_LABEL)
+            ok = neander_define_label(image, compiler->asmItems[i].operand, line);
+        else if (compiler->asmItems[i].kind == ITEM_INSTRUCTION)
+            ok = neander_emit(image, neander_opcode(compiler->asmItems[i].mnemonic),
+                              compiler->asmItems[i].operand[0] ? compiler->asmItems[i].operand : NULL, line);
+        if (!ok)
+            return false;
+    }
+    return neander_finish(image, line);
+}
+
+/*========================================================================
+  Library Interface
+
+  Each entry point installs its context as the thread's compiler for the
+  duration of the call and restores the previous one on the way out.
+========================================================================*/
+NeanderCompiler* neander_compiler_new(const NeanderCompileOptions* options) {
+    NeanderCompiler* c = calloc(1, sizeof(NeanderCompiler));
+    if (!c) {
+        perror("Erro na alocação de memória");
+        exit(1);
+    }
+    c->optimizeEnabled = options ? options->optimize : true;
+    c->propagateEnabled = options ? options->propagate : true;
+    c->log = options ? options->log : NULL;
+    return c;
+}
+
+void neander_compiler_free(NeanderCompiler* c) {
+    if (!c)
+        return;
+    arenaRelease(&c->arena);
+    free(c->internSlots);
+    free(c->valueSlots);
+    free(c->variableStates);
+    free(c->tokenArray);
+    free(c->inputCode);
+    free(c->asmItems);
+    free(c->symbols);
+    free(c->symbolIndex);
+    free(c->constantSlots);
+    free(c);
+}
+
+// Forgets the previous program but keeps the buffers for the next one
+static void resetCompiler(const char* source, size_t length) {
+    arenaRelease(&compiler->arena);
+    if (compiler->internSlots)
+        memset(compiler->internSlots, 0, compiler->internCapacity * sizeof(const char*));
+    compiler->internCount = 0;
+    
+    if (length + INPUT_PADDING > compiler->inputCapacity) {
+        free(compiler->inputCode);
+        compiler->inputCapacity = length + INPUT_PADDING;
+        compiler->inputCode = countedMalloc(compiler->inputCapacity);
+        if (!compiler->inputCode) {
+            perror("Erro na alocação de memória");
+            exit(1);
+        }
+    }
+    memcpy(compiler->inputCode, source, length);
+    memset(compiler->inputCode + length, 0, INPUT_PADDING);
+    
+    compiler->commandList = NULL;
+    compiler->lastCommand = NULL;
+    memset(&compiler->program, 0, sizeof(compiler->program));
+    compiler->variableStateCount = 0;
+    compiler->removedAssignments = 0;
+    compiler->symbolCount = 0;
+    if (compiler->symbolIndex)
+        memset(compiler->symbolIndex, -1, compiler->symbolIndexCapacity * sizeof(int));
+    for (size_t i = 0; i < compiler->constantCapacity; i++)
+        compiler->constantSlots[i].symbol = -1;
+    compiler->constantCount = 0;
+    compiler->tempVarCount = 0;
+    compiler->mulLabelCount = 0;
+    compiler->divLabelCount = 0;
+    compiler->itemCount = 0;
+    compiler->tempsBeforeAllocation = 0;
+    compiler->tempSlotCount = 0;
+    compiler->peakLiveTemps = 0;
+    memset(&compiler->stats, 0, sizeof(compiler->stats));
+    compiler->nodeCount = 0;
+    compiler->error[0] = '\0';
+}
+
+bool neander_compile(NeanderCompiler* c, const char* source, size_t length) {
+    NeanderCompiler* previous = compiler;
+    compiler = c;
+    if (setjmp(c->failure)) {
+        compiler = previous;
+        return false;
+    }
+    
+    resetCompiler(source, length);
+    PhaseMark mark = startPhase();
+    scanTokens();
+    finishPhase(NEANDER_PHASE_SCAN, &mark);
+    
+    mark = startPhase();
+    parseProgram();
+    compiler->stats.syntax_nodes = compiler->nodeCount;
+    for (Command* cmd = compiler->commandList; cmd; cmd = cmd->next)
+        compiler->stats.commands++;
+    finishPhase(NEANDER_PHASE_PARSE, &mark);
+    
+    generateAssemblyCode();
+    
+    int instructions = countInstructions();
+    if (instructions > INSTRUCTION_LIMIT)
+        compileError("Erro: código com %d instruções excede a área de programa (%d)", instructions, INSTRUCTION_LIMIT);
+    int memoryWords = 2 * instructions + countDataWords();
+    if (memoryWords > MEMORY_WORD_LIMIT)
+        compileError("Erro: código e dados ocupam %d palavras, mais que as %d da memória", memoryWords, MEMORY_WORD_LIMIT);
+    
+    compiler = previous;
+    return true;
+}
+
+const char* neander_compiler_error(const NeanderCompiler* c) {
+    return c->error;
+}
+
+int neander_compiler_scan(NeanderCompiler* c, const char* source, size_t length) {
+    NeanderCompiler* previous = compiler;
+    compiler = c;
+    resetCompiler(source, length);
+    scanTokens();
+    compiler = previous;
+    return c->tokenTotal;
+}
+
+void neander_compiler_stats(NeanderCompiler* c, NeanderCompileStats* stats) {
+    NeanderCompiler* previous = compiler;
+    compiler = c;
+    *stats = c->stats;
+    stats->tokens = c->tokenTotal;
+    
+    markReferences();
+    for (int i = 0; i < c->symbolCount; i++) {
+        NeanderSymbolCount* count = c->symbols[i].category == SYMBOL_USER ? &stats->user
+                                  : c->symbols[i].category == SYMBOL_CONSTANT ? &stats->constants
+                                  : c->symbols[i].category == SYMBOL_TEMPORARY ? &stats->temporaries
+                                  : &stats->builtins;
+        count->total++;
+        if (c->symbols[i].referenced) {
+            count->data++;
+            stats->data_words++;
+        }
+    }
+    stats->instructions = countInstructions();
+    stats->memory_words = 2 * stats->instructions + stats->data_words;
+    compiler = previous;
+}
+
+void neander_compiler_write_listing(NeanderCompiler* c, FILE* out) {
+    NeanderCompiler* previous = compiler;
+    compiler = c;
+    writeListing(out);
+    compiler = previous;
+}
+
+bool neander_compiler_image(NeanderCompiler* c, NeanderAssembler* image) {
+    NeanderCompiler* previous = compiler;
+    compiler = c;
+    bool ok = assembleProgram(image);
+    compiler = previous;
+    return ok;
+}